@@ -27,8 +27,21 @@
 
 #include <coroutine>
 #include <exception>
-#include <any>
 #include <functional>
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <atomic>
+#include <utility>
+#include <cstdlib>
+#include <cstdint>
+#include <source_location>
+#if __has_include(<expected>)
+#include <expected>
+#endif
+#if !defined(__GNUC__)&&!defined(__clang__)&&!defined(_MSC_VER)&&__cpp_rtti
+#include <typeinfo> // names of awaited types
+#endif
 
 /*
  * version 1.0.0 Everything Move Only
@@ -80,7 +93,435 @@
  * changes:
  * - chzn::notifier now use custom list, because handle std::list::iterator only is not enough to erase element;
  * */
+/*
+ * version 1.2.0 Pooled Coroutine Frame
+ * 2026/10/16
+ * changes:
+ * - coroutine frames of chzn::async<T> and chzn::task are allocated from a thread local frame pool;
+ *   frames are rounded up to size classes of 64 bytes, frames bigger than 1024 bytes still use global operator new;
+ *   a freed frame goes back to the pool of the thread which frees it;
+ *   at most CHZN_ASYNC_FRAME_POOL_LIMIT (default 1024) frames are kept per size class;
+ * - define CHZN_ASYNC_NO_FRAME_POOL before include to turn it off;
+ * type:
+ * - chzn::frame_pool_stats
+ *   usage:
+ *   - counters of the frame pool of current thread;
+ *   - hits:   frames reused from pool;
+ *   - misses: frames allocated by global operator new;
+ * function:
+ * - chzn::frame_pool_statistics()
+ *   get frame_pool_stats of current thread;
+ *
+ * version 1.2.1 Custom Frame Allocator
+ * 2026/10/16
+ * changes:
+ * - a coroutine return chzn::async<T> or chzn::task can take leading parameters (std::allocator_arg_t,Alloc),
+ *   its frame will be allocated by Alloc, and freed by a copy of Alloc stored in frame;
+ *   for member function or lambda, they are the parameters after *this;
+ *   async<int> f(std::allocator_arg_t,arena_allocator<int> alloc,int x);
+ *   f(std::allocator_arg,alloc,1);
+ * - frames created by chzn::task to co_await something use the allocator of the task;
+ *
+ * version 1.2.2
+ * 2026/10/16
+ * changes:
+ * - slots of chzn::notifier live in frames of awaiting coroutines, notifier only keep a sentinel of intrusive list,
+ *   co_await and notify no longer allocate;
+ * - chzn::task co_await notifier use the slot in task frame, cancel() erase it from list;
+ *
+ * version 1.2.3
+ * 2026/10/16
+ * changes:
+ * - chzn::awaiter<T,buffer_size=64,allow_heap=true> no longer use std::any,
+ *   awaitable is stored in an inline buffer and called through a static vtable;
+ *   awaitable bigger than buffer_size (or not nothrow movable) is stored in heap,
+ *   static_assert when allow_heap is false;
+ *   define CHZN_AWAITER_BUFFER_SIZE before include to change default buffer_size;
+ * - chzn::awaiter keep the result of await_suspend (bool or coroutine handle) of awaitable;
+ *
+ * version 1.10.0 Zero Copy Notify
+ * 2026/10/16
+ * type:
+ * - chzn::notifier<T>
+ *   member function:
+ *   - ref()
+ *     co_await it to get const T& to the notified value instead of a copy,
+ *     valid until the coroutine suspends again;
+ *   - shared()
+ *     co_await it to get std::shared_ptr<const T> to the notified value, to keep it;
+ *     notify(t) copies t once for all waiters of shared(), notify_shared(p) gives them p;
+ *   - notify_shared(std::shared_ptr<const T> p)
+ *     same as notify(*p), but no copy for waiters of shared();
+ *
+ * version 1.11.0 Run Queue
+ * 2026/10/16
+ * type:
+ * - chzn::resume_policy
+ *   - immediate: notify resume waiters one by one, a waiter notifying another notifier recurse in stack (default);
+ *   - fifo/lifo: notify push waiters to a per thread queue, and the outermost notify run it in a flat loop,
+ *     notify in a resumed waiter only push, so stack depth is constant however deep the chain goes;
+ *     fifo run waiters in order of notify, lifo run waiters of latest notify first;
+ * function:
+ * - chzn::set_resume_policy(resume_policy p)
+ *   set policy of this thread, return the old one;
+ * - chzn::current_resume_policy()
+ * changes:
+ * - a notify in a resumed waiter with fifo/lifo copies the value once (or keep the shared_ptr of notify_shared),
+ *   ref() of its waiters stays valid until they suspend again;
+ * */
+/*
+ * version 1.12.0 Inline Cancellation
+ * 2026/10/16
+ * changes:
+ * - chzn::task co_await an awaiter with member await_cancel() keeps it in the task frame and register it as cancel slot,
+ *   task::cancel() call await_cancel(), after which the awaiter never resumes the task;
+ *   notifier (and ref()/shared()), concurrent_notifier, sleep_for/sleep_until, channel send/recv and chzn::async have it,
+ *   co_await them in a task costs no frame more than in a chzn::async;
+ * - canceled chzn::async keeps running detached and destroys itself when done;
+ * - other awaitables are still co_awaited in a wrapper frame;
+ * - cancel must not race with completion of the awaited, as before;
+ * */
+/*
+ * version 1.13.0 Expected
+ * 2026/10/16
+ * function:
+ * - chzn::notifier<T>::checked()
+ *   requires std::expected (C++23);
+ *   co_await it to get std::expected<T,chzn::no_longer_awaitable>, the error when the notifier destructs, nothing is thrown;
+ * changes:
+ * - in a coroutine return chzn::async<std::expected<T,E>>, requires std::expected (C++23):
+ *   - co_await chzn::async<std::expected<U,F>> get U, or the coroutine returns std::unexpected(error) at once,
+ *     without resuming it, local variables destructs as usual, F must be convertible to E;
+ *   - co_await std::expected<U,F> likewise;
+ *   - other awaitables are not changed;
+ * - compiles with -fno-exceptions, where an exception would be thrown std::abort() is called instead;
+ * */
+#ifndef CHZN_ASYNC_FRAME_POOL_LIMIT
+#define CHZN_ASYNC_FRAME_POOL_LIMIT 1024
+#endif
+// -fno-exceptions: abort where an exception would be thrown
+#if __cpp_exceptions
+#define CHZN_ASYNC_THROW(...) throw __VA_ARGS__
+#else
+#define CHZN_ASYNC_THROW(...) std::abort()
+#endif
+// tracing hooks, define CHZN_ASYNC_TRACE before include to record them, see version 1.18.0 Trace
+#ifdef CHZN_ASYNC_TRACE
+#define CHZN_ASYNC_TRACE_EVENT(kind,frame,what) ::chzn::trace_record(::chzn::trace_kind::kind,frame,what)
+#else
+#define CHZN_ASYNC_TRACE_EVENT(kind,frame,what) ((void)0)
+#endif
+// slow resume watchdog, define CHZN_ASYNC_WATCHDOG before include to time resume slices, see version 1.20.0 Watchdog
+#ifdef CHZN_ASYNC_WATCHDOG
+#define CHZN_ASYNC_WATCHDOG_NEST ::chzn::_detail::_watchdog_nest _watchdog_nest_
+#else
+#define CHZN_ASYNC_WATCHDOG_NEST ((void)0)
+#endif
 namespace chzn{
+    enum class trace_kind:unsigned char{
+        create,
+        first_resume,
+        suspend,
+        resume,
+        destroy,
+    };
+
+    inline void trace_record(trace_kind kind,const void *frame,const char *what) noexcept;
+
+    namespace _detail{
+        // counters of version 1.19.0 Stats
+        inline void _stats_frame(std::ptrdiff_t count,std::ptrdiff_t bytes) noexcept;
+        inline void _stats_adopted() noexcept;
+        inline void _stats_notify(std::size_t fanout) noexcept;
+        inline void _stats_waiters(std::ptrdiff_t count) noexcept;
+        // cooperative budget of version 1.21.0 Coop
+        inline void _coop_refill() noexcept;
+        inline bool _coop_exhausted() noexcept;
+        inline std::coroutine_handle<> _coop_reschedule(std::coroutine_handle<> handle);
+#ifdef CHZN_ASYNC_STATS_LATENCY
+        inline std::uint64_t _latency_now() noexcept;
+        inline void _latency_record(const char *what,std::uint64_t ticks) noexcept;
+#endif
+
+        // where a coroutine is defined, captured by get_return_object of async and task for the watchdog, empty if off
+        struct _where{
+#ifdef CHZN_ASYNC_WATCHDOG
+            std::source_location location;
+
+            _where(std::source_location location=std::source_location::current()) noexcept:location(location){}
+#endif
+        };
+
+        template<typename P>
+        const _where *_where_of([[maybe_unused]] std::coroutine_handle<P> handle) noexcept{
+            if constexpr(requires{{handle.promise().where}->std::convertible_to<const _where &>;})return &handle.promise().where;
+            else return nullptr;
+        }
+
+#ifdef CHZN_ASYNC_WATCHDOG
+        // the resume slice running in this thread, from a resume to the next suspend
+        struct _watchdog_slice{
+            std::uint64_t start=0; // elapsed ticks while paused by a nested resume
+            const void *frame=nullptr;
+            const _where *where=nullptr;
+            const char *what=nullptr;
+        };
+
+        inline void _watchdog_resume(const void *frame,const _where *where,const char *what) noexcept;
+        inline void _watchdog_suspend(const void *frame,const char *what) noexcept;
+
+        // around resuming a coroutine in the stack of another coroutine or an event loop,
+        // the outer slice is paused, the inner one ends when it returns
+        struct _watchdog_nest{
+            _watchdog_slice outer;
+
+            inline _watchdog_nest() noexcept;
+
+            _watchdog_nest(_watchdog_nest &) = delete;
+
+            inline ~_watchdog_nest();
+        };
+#endif
+
+        // kept in an awaiter from suspend to resume, for trace events, resume latency and watchdog, empty if all are off
+        struct _await_probe{
+#if defined(CHZN_ASYNC_TRACE)||defined(CHZN_ASYNC_WATCHDOG)
+            void *frame=nullptr;
+#endif
+#if defined(CHZN_ASYNC_STATS_LATENCY)||defined(CHZN_ASYNC_WATCHDOG)
+            const char *what=nullptr;
+#endif
+#ifdef CHZN_ASYNC_STATS_LATENCY
+            std::uint64_t since=0;
+#endif
+#ifdef CHZN_ASYNC_WATCHDOG
+            const _where *where=nullptr;
+#endif
+
+            void suspend([[maybe_unused]] void *frame,[[maybe_unused]] const char *what,
+                         [[maybe_unused]] const _where *where=nullptr) noexcept{
+#ifdef CHZN_ASYNC_WATCHDOG
+                _watchdog_suspend(frame,what);
+                this->frame=frame;
+                this->where=where;
+#endif
+#ifdef CHZN_ASYNC_TRACE
+                trace_record(trace_kind::suspend,this->frame=frame,what);
+#endif
+#if defined(CHZN_ASYNC_STATS_LATENCY)||defined(CHZN_ASYNC_WATCHDOG)
+                this->what=what;
+#endif
+#ifdef CHZN_ASYNC_STATS_LATENCY
+                since=_latency_now();
+#endif
+            }
+
+            // no-op if not suspended
+            void resume() noexcept{
+#ifdef CHZN_ASYNC_TRACE
+                if(frame)trace_record(trace_kind::resume,frame,nullptr);
+#endif
+#ifdef CHZN_ASYNC_STATS_LATENCY
+                if(since)_latency_record(what,_latency_now()-std::exchange(since,0));
+#endif
+#ifdef CHZN_ASYNC_WATCHDOG
+                if(frame)_watchdog_resume(frame,where,what); // last, the slice starts when the coroutine continues
+#endif
+#if defined(CHZN_ASYNC_TRACE)||defined(CHZN_ASYNC_WATCHDOG)
+                frame=nullptr;
+#endif
+            }
+        };
+
+        // final suspend of async and task, end of the last slice
+        inline void _probe_final([[maybe_unused]] void *frame) noexcept{
+            CHZN_ASYNC_TRACE_EVENT(suspend,frame,"final_suspend");
+#ifdef CHZN_ASYNC_WATCHDOG
+            _watchdog_suspend(frame,"final_suspend");
+#endif
+        }
+    }
+
+    struct frame_pool_stats{
+        std::size_t hits=0;
+        std::size_t misses=0;
+    };
+
+    namespace _detail{
+        struct _frame_pool{
+            static constexpr std::size_t granularity=64;
+            static constexpr std::size_t classes=16;
+
+            struct block{
+                block *next;
+            };
+
+            block *free_list[classes]{};
+            std::size_t cached[classes]{};
+            frame_pool_stats stats;
+
+            // frames may be freed by static destructors after the pool of this thread has gone
+            static bool &destroyed() noexcept{
+                thread_local bool d=false;
+                return d;
+            }
+
+            static _frame_pool &local() noexcept{
+                thread_local _frame_pool pool;
+                return pool;
+            }
+
+            static void *allocate(std::size_t size){
+                auto c=(size-1)/granularity;
+                if(c>=classes)[[unlikely]]return ::operator new(size);
+                if(destroyed())[[unlikely]]return ::operator new((c+1)*granularity);
+                auto &pool=local();
+                if(auto b=pool.free_list[c]){
+                    pool.free_list[c]=b->next;
+                    --pool.cached[c];
+                    ++pool.stats.hits;
+                    return b;
+                }
+                ++pool.stats.misses;
+                return ::operator new((c+1)*granularity);
+            }
+
+            static void deallocate(void *ptr,std::size_t size) noexcept{
+                auto c=(size-1)/granularity;
+                if(c>=classes||destroyed())[[unlikely]]return ::operator delete(ptr);
+                auto &pool=local();
+                if(pool.cached[c]>=CHZN_ASYNC_FRAME_POOL_LIMIT)return ::operator delete(ptr);
+                pool.free_list[c]=new(ptr) block{pool.free_list[c]};
+                ++pool.cached[c];
+            }
+
+            ~_frame_pool(){
+                for(auto b:free_list)
+                    for(block *next;b;b=next){
+                        next=b->next;
+                        ::operator delete(b);
+                    }
+                destroyed()=true;
+            }
+        };
+
+        // every frame ends with a trailer telling how to free it,
+        // so that one operator delete serves pooled frames and frames from caller supplied allocators
+        using _frame_deallocate=void (*)(void *frame,std::size_t size) noexcept;
+
+        constexpr std::size_t _align_up(std::size_t size,std::size_t align) noexcept{
+            return (size+align-1)/align*align;
+        }
+
+        inline _frame_deallocate &_frame_trailer(void *frame,std::size_t size) noexcept{
+            return *reinterpret_cast<_frame_deallocate *>(static_cast<std::byte *>(frame)+_align_up(size,alignof(_frame_deallocate)));
+        }
+
+        inline std::size_t _frame_trailer_end(std::size_t size) noexcept{
+            return _align_up(size,alignof(_frame_deallocate))+sizeof(_frame_deallocate);
+        }
+
+        inline void *_default_frame_allocate(std::size_t size){
+#ifndef CHZN_ASYNC_NO_FRAME_POOL
+            void *frame=_frame_pool::allocate(_frame_trailer_end(size));
+            _frame_trailer(frame,size)=[](void *frame,std::size_t size) noexcept{
+                _frame_pool::deallocate(frame,_frame_trailer_end(size));
+            };
+#else
+            void *frame=::operator new(_frame_trailer_end(size));
+            _frame_trailer(frame,size)=[](void *frame,std::size_t) noexcept{::operator delete(frame);};
+#endif
+            CHZN_ASYNC_TRACE_EVENT(create,frame,nullptr);
+            _stats_frame(1,static_cast<std::ptrdiff_t>(size));
+            return frame;
+        }
+
+        // frame layout: [frame][trailer][allocator], allocator is stored in frame and used to free it
+        template<typename Alloc>
+        struct _frame_allocator{
+            struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) unit{
+                std::byte data[__STDCPP_DEFAULT_NEW_ALIGNMENT__];
+            };
+            using allocator_type=typename std::allocator_traits<Alloc>::template rebind_alloc<unit>;
+            using traits=std::allocator_traits<allocator_type>;
+
+            static std::size_t allocator_offset(std::size_t size) noexcept{
+                return _align_up(_frame_trailer_end(size),alignof(allocator_type));
+            }
+
+            static std::size_t units(std::size_t size) noexcept{
+                return _align_up(allocator_offset(size)+sizeof(allocator_type),sizeof(unit))/sizeof(unit);
+            }
+
+            static allocator_type *stored(void *frame,std::size_t size) noexcept{
+                return std::launder(reinterpret_cast<allocator_type *>(static_cast<std::byte *>(frame)+allocator_offset(size)));
+            }
+
+            static void *allocate(const Alloc &a,std::size_t size){
+                allocator_type alloc(a);
+                void *frame=std::to_address(traits::allocate(alloc,units(size)));
+                _frame_trailer(frame,size)=&deallocate;
+                new(static_cast<std::byte *>(frame)+allocator_offset(size)) allocator_type(std::move(alloc));
+                CHZN_ASYNC_TRACE_EVENT(create,frame,nullptr);
+                _stats_frame(1,static_cast<std::ptrdiff_t>(size));
+                return frame;
+            }
+
+            static void deallocate(void *frame,std::size_t size) noexcept{
+                auto ptr=stored(frame,size);
+                allocator_type alloc(std::move(*ptr));
+                ptr->~allocator_type();
+                traits::deallocate(alloc,static_cast<unit *>(frame),units(size));
+            }
+        };
+
+        // type erased reference to a caller supplied allocator, to allocate child frames with it
+        struct _frame_allocator_ref{
+            const void *allocator=nullptr;
+            void *(*allocate_func)(const void *,std::size_t)=nullptr;
+
+            _frame_allocator_ref() = default;
+
+            template<typename Alloc>
+            _frame_allocator_ref(const Alloc &a):allocator(&a),allocate_func([](const void *a,std::size_t size){
+                return _frame_allocator<Alloc>::allocate(*static_cast<const Alloc *>(a),size);
+            }){}
+
+            void *allocate(std::size_t size) const{
+                if(allocate_func)return allocate_func(allocator,size);
+                return _default_frame_allocate(size);
+            }
+        };
+
+        // base of promise_type, allocate coroutine frame from _frame_pool,
+        // or from allocator given by leading parameters (std::allocator_arg_t,Alloc)
+        struct _frame_memory{
+            static void *operator new(std::size_t size){return _default_frame_allocate(size);}
+
+            template<typename Alloc,typename...Args>
+            static void *operator new(std::size_t size,std::allocator_arg_t,const Alloc &alloc,const Args &...){
+                return _frame_allocator<Alloc>::allocate(alloc,size);
+            }
+
+            // member function coroutine, first parameter is *this
+            template<typename This,typename Alloc,typename...Args>
+            static void *operator new(std::size_t size,const This &,std::allocator_arg_t,const Alloc &alloc,const Args &...){
+                return _frame_allocator<Alloc>::allocate(alloc,size);
+            }
+
+            static void operator delete(void *ptr,std::size_t size) noexcept{
+                CHZN_ASYNC_TRACE_EVENT(destroy,ptr,nullptr);
+                _stats_frame(-1,-static_cast<std::ptrdiff_t>(size));
+                _frame_trailer(ptr,size)(ptr,size);
+            }
+        };
+    }
+
+    inline frame_pool_stats frame_pool_statistics() noexcept{
+        if(_detail::_frame_pool::destroyed())[[unlikely]]return {};
+        return _detail::_frame_pool::local().stats;
+    }
+
     template<typename T>
     struct async;
     namespace _detail{
@@ -94,14 +535,18 @@ namespace chzn{
 
         // helper class to release coroutine handle at correct time
         struct unowned_promise{
-            struct promise_type{
+            struct promise_type:public _frame_memory{
                 unowned_promise get_return_object(){return {handle_type::from_promise(*this)};}
 
                 constexpr std::suspend_never initial_suspend() const noexcept{return {};}
 
                 constexpr std::suspend_never final_suspend() const noexcept{return {};}
 
-                static void unhandled_exception(){throw;}
+                static void unhandled_exception(){
+#if __cpp_exceptions
+                    throw;
+#endif
+                }
 
                 constexpr void return_void() const noexcept{}
             };
@@ -111,28 +556,217 @@ namespace chzn{
 
             template<typename T>
             static unowned_promise adopt(T promise){
+                _stats_adopted();
+#if __cpp_exceptions
                 try{
                     co_await promise;
                 }catch(awaiting_notifier_destructed){}
+#else
+                co_await promise;
+#endif
             }
 
             template<typename T>
             static void take(T promise){
+                _stats_adopted();
                 auto &await_by=promise.coroutine.promise().await_by;
                 await_by=[](T)->unowned_promise{co_await std::suspend_always{};}(std::move(promise)).coroutine;
             }
         };
+
+        // completion block shared by children of when_all/when_any, lives in frame of the combinator
+        struct _join{
+            std::atomic<std::size_t> count;            // when_all: children+1; when_any: 2, winner and starter
+            std::atomic<std::size_t> winner=-1;        // when_any only
+            std::atomic<std::size_t> finished=0;       // when_any only, losers done with this block
+            std::coroutine_handle<> parent{};
+            bool any=false;
+        };
+
+        struct _join_child{
+            _join *join=nullptr;
+            std::size_t index=0;
+            std::coroutine_handle<>(*on_arrive)(_join_child &)=nullptr; // called instead, by co_await in async<std::expected>
+
+            std::coroutine_handle<> arrive() noexcept{
+                if(on_arrive)[[unlikely]]return on_arrive(*this);
+                auto &j=*join;
+                if(j.any){
+                    std::size_t none=-1;
+                    if(!j.winner.compare_exchange_strong(none,index,std::memory_order_acq_rel)){
+                        j.finished.fetch_add(1,std::memory_order_release);
+                        return std::noop_coroutine();
+                    }
+                }
+                if(j.count.fetch_sub(1,std::memory_order_acq_rel)==1)return j.parent;
+                return std::noop_coroutine();
+            }
+        };
+
+        // states of async<T>::promise_type::join besides pointing to a _join_child
+        inline _join_child _join_detached,_join_arriving;
+
+        // called at final suspend of a child async
+        inline std::coroutine_handle<> _join_arrive(std::coroutine_handle<> handle,std::atomic<_join_child *> &join) noexcept{
+            auto child=join.exchange(&_join_arriving,std::memory_order_acq_rel);
+            if(child==&_join_detached){ // nobody owns it
+                handle.destroy();
+                return std::noop_coroutine();
+            }
+            return child->arrive();
+        }
+
+        // name of T for trace events, one pointer per type, parsed by _trace_type_name when exported
+#if defined(__GNUC__)||defined(__clang__)
+        template<typename T>
+        constexpr const char *_type_name() noexcept{return __PRETTY_FUNCTION__;} // "... [with T = name]"
+#elif defined(_MSC_VER)
+        template<typename T>
+        constexpr const char *_type_name() noexcept{return __FUNCSIG__;} // "... _type_name<name>(void) noexcept"
+#elif __cpp_rtti
+        template<typename T>
+        inline const char *_type_name() noexcept{return typeid(T).name();}
+#else
+        template<typename T>
+        inline const char *_type_name() noexcept{
+            static const char name[]="awaitable";
+            return name;
+        }
+#endif
+
+#if defined(CHZN_ASYNC_TRACE)||defined(CHZN_ASYNC_WATCHDOG)
+        // initial suspend of async, record first resume and start the first watchdog slice
+        struct _initial_suspend{
+            void *frame=nullptr;
+#ifdef CHZN_ASYNC_WATCHDOG
+            const _where *where=nullptr;
+#endif
+
+            static constexpr bool await_ready() noexcept{return false;}
+
+            template<typename P>
+            void await_suspend(std::coroutine_handle<P> handle) noexcept{
+                frame=handle.address();
+#ifdef CHZN_ASYNC_WATCHDOG
+                where=_where_of(handle);
+#endif
+            }
+
+            void await_resume() const noexcept{
+                CHZN_ASYNC_TRACE_EVENT(first_resume,frame,nullptr);
+#ifdef CHZN_ASYNC_WATCHDOG
+                _watchdog_resume(frame,where,"initial_suspend");
+#endif
+            }
+        };
+#else
+        using _initial_suspend=std::suspend_always;
+#endif
+
+        struct _final_suspend:public std::suspend_always{
+            static void await_suspend(std::coroutine_handle<> handle) noexcept{
+                _probe_final(handle.address());
+            }
+        };
+
+        // base of async<T>::promise_type, co_await short circuit in async<std::expected<T,E>>
+        template<typename T>
+        struct _expected_promise{
+        };
+
+#if __cpp_lib_expected
+        template<typename T>
+        struct _is_expected:std::false_type{
+        };
+
+        template<typename T,typename E>
+        struct _is_expected<std::expected<T,E>>:std::true_type{
+        };
+
+        // finish coroutine of promise P with error e at a suspend point, return what its final suspend would resume
+        template<typename P,typename E>
+        std::coroutine_handle<> _return_unexpected(std::coroutine_handle<P> handle,E &&e) noexcept{
+            handle.promise().return_value(std::unexpected(std::forward<E>(e)));
+            return typename P::suspend_final{}.await_suspend(handle);
+        }
+
+        // co_await std::expected<T,E>, the value or finish with the error
+        template<typename X>
+        struct _expected_value_awaiter{
+            X &&x;
+
+            bool await_ready() const noexcept{return x.has_value();}
+
+            template<typename P>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept{
+                return _return_unexpected(handle,std::forward<X>(x).error());
+            }
+
+            decltype(auto) await_resume(){
+                if constexpr(!std::is_void_v<typename std::remove_cvref_t<X>::value_type>)return *std::forward<X>(x);
+            }
+        };
+
+        // co_await async<std::expected<T,E>>, the child arrive here at final suspend and resume or finish the parent
+        template<typename T,typename E>
+        struct _expected_async_awaiter:public _join_child{
+            async<std::expected<T,E>> child;
+            std::coroutine_handle<> parent{};
+            std::coroutine_handle<>(*fail)(_expected_async_awaiter &) noexcept=nullptr;
+
+            bool await_ready() const noexcept{return child.coroutine.done();}
+
+            template<typename P>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept{
+                parent=handle;
+                fail=[](_expected_async_awaiter &a) noexcept{
+                    auto e=std::move(reinterpret_cast<std::expected<T,E> &>(a.child.coroutine.promise().value).error());
+                    return _return_unexpected(std::coroutine_handle<P>::from_address(a.parent.address()),std::move(e)); // a is gone
+                };
+                on_arrive=[](_join_child &j) noexcept{
+                    auto &a=static_cast<_expected_async_awaiter &>(j);
+                    auto &p=a.child.coroutine.promise();
+                    if(p.state==returned&&!reinterpret_cast<std::expected<T,E> &>(p.value).has_value())return a.fail(a);
+                    return a.parent;
+                };
+                child.coroutine.promise().join.store(this,std::memory_order_relaxed);
+                return child.coroutine;
+            }
+
+            T await_resume(){
+                auto &p=child.coroutine.promise();
+                if(p.state==throws)std::rethrow_exception(p.error);
+                if constexpr(!std::is_void_v<T>)return std::move(*reinterpret_cast<std::expected<T,E> &>(p.value));
+            }
+        };
+
+        template<typename T,typename E>
+        struct _expected_promise<std::expected<T,E>>{
+            template<typename U>
+            U &&await_transform(U &&u) noexcept{return std::forward<U>(u);}
+
+            template<typename U> requires _is_expected<std::remove_cvref_t<U>>::value
+                                          &&std::is_convertible_v<typename std::remove_cvref_t<U>::error_type,E>
+            _expected_value_awaiter<U> await_transform(U &&u) noexcept{return {std::forward<U>(u)};}
+
+            template<typename U,typename F> requires std::is_convertible_v<F,E>
+            _expected_async_awaiter<U,F> await_transform(async<std::expected<U,F>> &&u) noexcept{return {{},std::move(u)};}
+        };
+#endif
     }
 
     using no_longer_awaitable=_detail::awaiting_notifier_destructed;
 
     template<typename T=void>
     struct async{
-        struct promise_type{
-            async<T> get_return_object(){return {handle_type::from_promise(*this)};}
+        struct promise_type:public _detail::_frame_memory,public _detail::_expected_promise<T>{
+            async<T> get_return_object(_detail::_where where={}){
+                this->where=where;
+                return {handle_type::from_promise(*this)};
+            }
 
             // suspend at start to make caller co_await this, then set await_by when this be co_await
-            constexpr std::suspend_always initial_suspend() const noexcept{return {};}
+            constexpr _detail::_initial_suspend initial_suspend() const noexcept{return {};}
 
             void return_value(T t){
                 new(&value) T(std::move(t));
@@ -146,6 +780,11 @@ namespace chzn{
 
             struct suspend_final:public std::suspend_always{
                 std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept{
+                    _detail::_probe_final(handle.address());
+                    auto &join=handle.promise().join;
+                    if(join.load(std::memory_order_relaxed))[[unlikely]]return _detail::_join_arrive(handle,join);
+                    if(handle.promise().reschedulable&&_detail::_coop_exhausted())[[unlikely]]
+                        return _detail::_coop_reschedule(handle.promise().await_by);
                     return handle.promise().await_by;
                 }
             };
@@ -171,7 +810,10 @@ namespace chzn{
                 std::exception_ptr error{};
             };
             std::coroutine_handle<> await_by=std::noop_coroutine(); // caller
+            std::atomic<_detail::_join_child *> join=nullptr; // set when awaited by when_all/when_any
             _detail::coroutine_state state=_detail::awaiting;
+            bool reschedulable=false; // awaited by async, not canceled, its caller may continue later by coop budget
+            [[no_unique_address]] _detail::_where where;
         };
 
         using handle_type=std::coroutine_handle<promise_type>;
@@ -179,18 +821,23 @@ namespace chzn{
 
         struct awaiter{
             handle_type coroutine;
+            [[no_unique_address]] mutable _detail::_await_probe probe{};
 
             // never ready
             bool await_ready() const noexcept{
                 return coroutine.done(); // always false
             }
 
-            auto await_suspend(std::coroutine_handle<> handle) const noexcept{
+            template<typename P>
+            auto await_suspend(std::coroutine_handle<P> handle) const noexcept{
+                probe.suspend(handle.address(),_detail::_type_name<async<T>>(),_detail::_where_of(handle));
                 coroutine.promise().await_by=handle;
+                coroutine.promise().reschedulable=true;
                 return coroutine;
             }
 
             T await_resume() const{
+                probe.resume();
                 if(coroutine.promise().state==_detail::throws)
                     std::rethrow_exception(coroutine.promise().error);
                 return std::move(reinterpret_cast<T &>(coroutine.promise().value));
@@ -204,7 +851,7 @@ namespace chzn{
 
         ~async(){
             if(!coroutine.operator bool())[[unlikely]]return; // someone constructed empty object
-            if(!coroutine.done()){ // free
+            if(!coroutine.done()&&coroutine.promise().state==_detail::awaiting){ // free, not finished by an error short circuit
                 _detail::unowned_promise::adopt(std::move(*this));
             }else coroutine.destroy(); // co_awaited
         }
@@ -231,17 +878,20 @@ namespace chzn{
     };
 
     template<>
-    struct async<void>::promise_type{
-        async<void> get_return_object(){return {handle_type::from_promise(*this)};}
+    struct async<void>::promise_type:public _detail::_frame_memory{
+        async<void> get_return_object(_detail::_where where={}){
+            this->where=where;
+            return {handle_type::from_promise(*this)};
+        }
 
-        constexpr std::suspend_always initial_suspend() const noexcept{return {};}
+        constexpr _detail::_initial_suspend initial_suspend() const noexcept{return {};}
 
         void return_void(){
             state=_detail::returned;
         }
 
         void unhandled_exception(){
-            new(&error) std::exception_ptr(std::current_exception());
+            error=std::current_exception();
             state=_detail::throws;
         }
 
@@ -249,6 +899,11 @@ namespace chzn{
             constexpr bool await_ready() const noexcept{return false;}
 
             std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept{
+                _detail::_probe_final(handle.address());
+                auto &join=handle.promise().join;
+                if(join.load(std::memory_order_relaxed))[[unlikely]]return _detail::_join_arrive(handle,join);
+                if(handle.promise().reschedulable&&_detail::_coop_exhausted())[[unlikely]]
+                    return _detail::_coop_reschedule(handle.promise().await_by);
                 return handle.promise().await_by;
             }
 
@@ -259,225 +914,492 @@ namespace chzn{
             return {};
         }
 
-        ~promise_type(){
-            if(state==_detail::throws){
-                error.~exception_ptr();
-            }
-        }
-
         std::exception_ptr error{};
         std::coroutine_handle<> await_by=std::noop_coroutine();
+        std::atomic<_detail::_join_child *> join=nullptr;
         _detail::coroutine_state state=_detail::awaiting;
+        bool reschedulable=false;
+        [[no_unique_address]] _detail::_where where;
     };
 
     template<>
     struct async<void>::awaiter{
         handle_type coroutine;
+        [[no_unique_address]] mutable _detail::_await_probe probe{};
 
         bool await_ready() const noexcept{
             return coroutine.done();
         }
 
-        auto await_suspend(std::coroutine_handle<> handle) const noexcept{
+        template<typename P>
+        auto await_suspend(std::coroutine_handle<P> handle) const noexcept{
+            probe.suspend(handle.address(),_detail::_type_name<async<void>>(),_detail::_where_of(handle));
             coroutine.promise().await_by=handle;
+            coroutine.promise().reschedulable=true;
             return coroutine;
         }
 
         void await_resume() const{
+            probe.resume();
             if(coroutine.promise().state==_detail::throws)
                 std::rethrow_exception(coroutine.promise().error);
         }
     };
 
     namespace _detail{
+        // static vtable, storage is the inline buffer of awaiter, or holds a pointer to heap object
         template<typename T>
         struct _awaiter_operator{
-            bool (*ready)(std::any &);
+            bool (*ready)(void *);
+
+            std::coroutine_handle<> (*suspend)(void *,std::coroutine_handle<>);
 
-            void (*suspend)(std::any &,std::coroutine_handle<>);
+            T (*resume)(void *);
 
-            T (*resume)(std::any &);
+            void (*move)(void *from,void *to) noexcept; // move construct to, then destroy from
+
+            void (*destroy)(void *) noexcept;
         };
 
-        template<typename U>
+        template<typename U,bool inline_storage>
         struct _awaiter_operator_helper{
-            static _awaiter_operator<std::invoke_result_t<decltype(&U::await_resume),U &>> &func(){
-                static _awaiter_operator<std::invoke_result_t<decltype(&U::await_resume),U &>> op={
-                        .ready=[](std::any &self){
-                            return std::any_cast<U &>(self).await_ready();
-                        },
-                        .suspend=[](std::any &self,std::coroutine_handle<> handle){
-                            std::any_cast<U &>(self).await_suspend(handle);
-                        },
-                        .resume=[](std::any &self){
-                            return std::any_cast<U &>(self).await_resume();
-                        }
-                };
-                return op;
+            using result_type=std::invoke_result_t<decltype(&U::await_resume),U &>;
+
+            static U &get(void *storage) noexcept{
+                if constexpr(inline_storage)return *std::launder(static_cast<U *>(storage));
+                else return **static_cast<U **>(storage);
+            }
+
+            // void: suspend; bool: suspend if true; handle: transfer to it
+            static std::coroutine_handle<> suspend(void *storage,std::coroutine_handle<> handle){
+                using R=decltype(get(storage).await_suspend(handle));
+                if constexpr(std::is_void_v<R>){
+                    get(storage).await_suspend(handle);
+                    return std::noop_coroutine();
+                }else if constexpr(std::is_same_v<R,bool>){
+                    if(get(storage).await_suspend(handle))return std::noop_coroutine();
+                    return handle;
+                }else return get(storage).await_suspend(handle);
             }
+
+            static constexpr _awaiter_operator<result_type> op={
+                    .ready=[](void *storage){
+                        return static_cast<bool>(get(storage).await_ready());
+                    },
+                    .suspend=&suspend,
+                    .resume=[](void *storage)->result_type{
+                        return get(storage).await_resume();
+                    },
+                    .move=[](void *from,void *to) noexcept{
+                        if constexpr(inline_storage){
+                            new(to) U(std::move(get(from)));
+                            get(from).~U();
+                        }else *static_cast<U **>(to)=*static_cast<U **>(from);
+                    },
+                    .destroy=[](void *storage) noexcept{
+                        if constexpr(inline_storage)get(storage).~U();
+                        else delete &get(storage);
+                    }
+            };
         };
     }
 
-    template<typename T>
+#ifndef CHZN_AWAITER_BUFFER_SIZE
+#define CHZN_AWAITER_BUFFER_SIZE 64
+#endif
+
+    template<typename T,std::size_t buffer_size=CHZN_AWAITER_BUFFER_SIZE,bool allow_heap=true>
     struct awaiter{
-        std::any ptr;
-        _detail::_awaiter_operator<T> *op;
+        static_assert(buffer_size>=sizeof(void *),"chzn::awaiter buffer must be able to hold a pointer");
+
+        alignas(std::max_align_t) std::byte buffer[buffer_size];
+        const _detail::_awaiter_operator<T> *op=nullptr;
+
+        template<typename U>
+        static constexpr bool fits_inline=sizeof(U)<=buffer_size&&alignof(U)<=alignof(std::max_align_t)
+                                          &&std::is_nothrow_move_constructible_v<U>;
 
         template<typename U>
         requires std::invocable<decltype(&U::await_ready),U &>
-                 &&std::invocable<decltype(&U::await_suspend),U &,std::coroutine_handle<>>
+                 &&requires(U &u,std::coroutine_handle<> h){u.await_suspend(h);} // may be a template
                  &&std::invocable<decltype(&U::await_resume),U &>
-        awaiter(U t):op(&_detail::_awaiter_operator_helper<U>::func()),ptr(std::move(t)){}
+        awaiter(U t){
+            if constexpr(fits_inline<U>){
+                new(buffer) U(std::move(t));
+                op=&_detail::_awaiter_operator_helper<U,true>::op;
+            }else{
+                static_assert(allow_heap,"chzn::awaiter: awaitable is too big for inline buffer, and heap is not allowed");
+                *reinterpret_cast<U **>(buffer)=new U(std::move(t));
+                op=&_detail::_awaiter_operator_helper<U,false>::op;
+            }
+        }
 
-        bool await_ready(){return op->ready(ptr);}
+        bool await_ready(){return op->ready(buffer);}
 
-        void await_suspend(std::coroutine_handle<> handle){op->suspend(ptr,handle);}
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle){return op->suspend(buffer,handle);}
 
-        T await_resume(){return op->resume(ptr);}
+        T await_resume(){return op->resume(buffer);}
+
+        ~awaiter(){
+            if(op)op->destroy(buffer);
+        }
 
         awaiter(awaiter &) = delete;
 
-        awaiter(awaiter &&a) noexcept{
-            std::swap(ptr,a.ptr);
-            std::swap(op,a.op);
+        awaiter(awaiter &&a) noexcept:op(a.op){
+            if(op)op->move(a.buffer,buffer);
+            a.op=nullptr;
         }
 
         void operator=(awaiter &) = delete;
 
         awaiter &operator=(awaiter &&a) noexcept{
-            std::swap(ptr,a.ptr);
-            std::swap(op,a.op);
+            if(this==&a)return *this;
+            if(op)op->destroy(buffer);
+            op=a.op;
+            if(op)op->move(a.buffer,buffer);
+            a.op=nullptr;
             return *this;
         }
     };
 
     template<typename T> requires std::invocable<decltype(&T::await_ready),T &>
-                                  &&std::invocable<decltype(&T::await_suspend),T &,std::coroutine_handle<>>
+                                  &&requires(T &t,std::coroutine_handle<> h){t.await_suspend(h);}
                                   &&std::invocable<decltype(&T::await_resume),T &>
     awaiter(T t)->awaiter<std::invoke_result_t<decltype(&T::await_resume),T &>>;
 
+    template<typename T>
+    struct notifier;
+
+    enum class resume_policy{
+        immediate, // notify resume waiters one by one in its stack
+        fifo,      // notify queue waiters, run in a flat loop, breadth first
+        lifo,      // notify queue waiters, run in a flat loop, depth first
+    };
+
     namespace _detail{
-        template<typename T>
-        struct notifier_slot{
+        // node of intrusive circular list,
+        // a slot lives in the frame of the coroutine co_awaiting notifier, notifier only keep the sentinel
+        struct _slot_link{
+            _slot_link *last=this,*next=this;
+
+            _slot_link() = default;
+
+            // a copied slot is not in any list
+            _slot_link(const _slot_link &) noexcept{}
+
+            _slot_link &operator=(const _slot_link &) = delete;
+
+            ~_slot_link(){erase();}
+
+            bool linked() const noexcept{return next!=this;}
+
+            // O(1), erase a node not in list is no-op
+            void erase() noexcept{
+                last->next=next;
+                next->last=last;
+                last=next=this;
+            }
+        };
+
+        // part of notifier_slot<T> not depending on T
+        struct _notifier_slot_base:public _slot_link{
+            static constexpr bool self_traced=true; // has its own probe
+
             std::coroutine_handle<> coroutine;
+            void (*on_notify)(_notifier_slot_base &)=nullptr; // called instead of resuming coroutine, by when_all/when_any
+            std::shared_ptr<const void> keep; // owns the value when resumption is deferred
+            [[no_unique_address]] _await_probe probe{};
+
+            // leave notifier, or run queue if notified
+            void await_cancel() noexcept{leave();}
+
+            void leave() noexcept{
+                if(!linked())return;
+                erase();
+                _stats_waiters(-1);
+            }
+
+            void resume(){
+                _stats_waiters(-1);
+                if(on_notify)[[unlikely]]on_notify(*this);
+                else{
+                    CHZN_ASYNC_WATCHDOG_NEST;
+                    _detail::_coop_refill();
+                    probe.resume();
+                    coroutine.resume();
+                }
+            }
+        };
+
+        // per thread queue of notified slots, notify in a resumed coroutine only push to it
+        struct _run_queue{
+            _slot_link the_end;
+            resume_policy policy=resume_policy::immediate;
+            bool draining=false;
+
+            static _run_queue &local() noexcept{
+                thread_local _run_queue q;
+                return q;
+            }
+
+            // fifo: append; lifo: slots of one notify stay in order, before slots pushed earlier
+            void push(_notifier_slot_base &n,_slot_link *&pos) noexcept{
+                auto &before=policy==resume_policy::fifo?the_end:*pos;
+                n.last=before.last;
+                n.next=&before;
+                before.last->next=&n;
+                before.last=&n;
+                pos=&n;
+            }
+
+            void drain(){
+                struct guard{
+                    bool &d;
+
+                    ~guard(){d=false;}
+                } g{draining};
+                draining=true;
+                while(the_end.linked()){
+                    auto &n=static_cast<_notifier_slot_base &>(policy==resume_policy::lifo?*the_end.last:*the_end.next);
+                    n.erase();
+                    auto keep=n.keep; // value stays until the coroutine suspends again
+                    n.resume();
+                }
+            }
+        };
+
+        template<typename T>
+        struct notifier_slot;
+
+        template<typename T>
+        struct _notifier_slot_list{
+            _slot_link the_end;
+
+            bool empty() const noexcept{return !the_end.linked();}
+
+            void push(_slot_link &n) noexcept{
+                n.last=the_end.last;
+                n.next=&the_end;
+                the_end.last->next=&n;
+                the_end.last=&n;
+            }
+
+            notifier_slot<T> &pop() noexcept{
+                auto n=the_end.next;
+                n->erase();
+                return static_cast<notifier_slot<T> &>(*n);
+            }
+
+            // take all nodes of l, this must be empty
+            void splice(_notifier_slot_list &l) noexcept{
+                if(l.empty())return;
+                the_end.next=l.the_end.next;
+                the_end.last=l.the_end.last;
+                the_end.next->last=the_end.last->next=&the_end;
+                l.the_end.last=l.the_end.next=&l.the_end;
+            }
+
+            _notifier_slot_list() = default;
+
+            _notifier_slot_list(_notifier_slot_list &&l) noexcept{splice(l);}
+
+            _notifier_slot_list(_notifier_slot_list &) = delete;
+        };
+
+        template<typename T>
+        void swap(_notifier_slot_list<T> &a,_notifier_slot_list<T> &b){
+            _notifier_slot_list<T> t(std::move(a));
+            a.splice(b);
+            b.splice(t);
+        }
+
+        template<typename T>
+        struct notifier_slot:public _notifier_slot_base{
+            _notifier_slot_list<T> *list;
             T *value=nullptr;
+            std::shared_ptr<const T> *shared=nullptr; // made at most once per notify, for waiters of shared()
+
+            notifier_slot(_notifier_slot_list<T> &l) noexcept:list(&l){}
 
             bool await_ready() const noexcept{
                 return false;
             }
 
-            void await_suspend(std::coroutine_handle<> handle) noexcept{
+            template<typename P>
+            void await_suspend(std::coroutine_handle<P> handle) noexcept{
+                probe.suspend(handle.address(),_type_name<notifier<T>>(),_where_of(handle));
                 coroutine=handle;
+                list->push(*this);
+                _stats_waiters(1);
             }
 
             T await_resume() const{
-                if(value==nullptr)[[unlikely]]throw _detail::awaiting_notifier_destructed{};
+                if(value==nullptr)[[unlikely]]CHZN_ASYNC_THROW(_detail::awaiting_notifier_destructed{});
                 return *value;
             }
 
             void notify(T &t){
                 value=&t;
-                coroutine.resume();
+                resume();
             }
 
             void notify(T &&t){
                 value=&t;
-                coroutine.resume();
+                resume();
+            }
+
+            void notify(T &t,std::shared_ptr<const T> &s){
+                shared=&s;
+                notify(t);
+            }
+        };
+
+        // get const T& to the notified value
+        template<typename T>
+        struct _notifier_ref_slot:public notifier_slot<T>{
+            using notifier_slot<T>::notifier_slot;
+
+            const T &await_resume() const{
+                if(this->value==nullptr)[[unlikely]]CHZN_ASYNC_THROW(_detail::awaiting_notifier_destructed{});
+                return *this->value;
+            }
+        };
+
+        // get shared_ptr shared by all such waiters of one notify
+        template<typename T>
+        struct _notifier_shared_slot:public notifier_slot<T>{
+            using notifier_slot<T>::notifier_slot;
+
+            std::shared_ptr<const T> await_resume() const{
+                if(this->value==nullptr)[[unlikely]]CHZN_ASYNC_THROW(_detail::awaiting_notifier_destructed{});
+                if(this->keep)return std::static_pointer_cast<const T>(this->keep);
+                if(!this->shared)return std::make_shared<const T>(*this->value);
+                if(!*this->shared)*this->shared=std::make_shared<const T>(*this->value);
+                return *this->shared;
             }
         };
 
         template<>
-        struct notifier_slot<void>{
-            std::coroutine_handle<> coroutine;
+        struct notifier_slot<void>:public _notifier_slot_base{
+            _notifier_slot_list<void> *list;
             void *value=nullptr;
 
+            notifier_slot(_notifier_slot_list<void> &l) noexcept:list(&l){}
+
             bool await_ready() const noexcept{
                 return false;
             }
 
-            void await_suspend(std::coroutine_handle<> handle) noexcept{
+            template<typename P>
+            void await_suspend(std::coroutine_handle<P> handle) noexcept{
+                probe.suspend(handle.address(),_type_name<notifier<void>>(),_where_of(handle));
                 coroutine=handle;
+                list->push(*this);
+                _stats_waiters(1);
             }
 
             void await_resume() const{
-                if(value==nullptr)[[unlikely]]throw _detail::awaiting_notifier_destructed{};
+                if(value==nullptr)[[unlikely]]CHZN_ASYNC_THROW(_detail::awaiting_notifier_destructed{});
             }
 
             void notify(){
                 value=reinterpret_cast<void *>(0xdedeaded);
-                coroutine.resume();
+                resume();
             }
         };
 
+#if __cpp_lib_expected
+        // get std::expected, an error instead of exception when the notifier destructs
         template<typename T>
-        struct _notifier_slot_list{
-            struct node{
-                node *last,*next;notifier_slot<T> value;
-                // stl::list don't contain this, because it preserve size;
-                void erase(){
-                    last->next=next;
-                    next->last=last;
-                    delete this;
-                }
-            };
-            struct iterator{
-                node *n;
-                notifier_slot<T>& operator*(){return n->value;}
-                void operator++(){n=n->next;}
-                bool operator==(iterator b)const noexcept{return n==b.n;}
-            };
-            node *the_end;
+        struct _notifier_checked_slot:public notifier_slot<T>{
+            using notifier_slot<T>::notifier_slot;
 
-            _notifier_slot_list():the_end(new node){the_end->last=the_end->next=the_end;}
-            iterator begin(){return {the_end->next};}
-            iterator end(){return {the_end};}
-            notifier_slot<T>& push(){
-                auto new_node=new node{the_end->last,the_end,{}};
-                the_end->last->next=new_node;
-                the_end->last=new_node;
-                return new_node->value;
+            std::expected<T,awaiting_notifier_destructed> await_resume() const{
+                if(this->value==nullptr)[[unlikely]]return std::unexpected(awaiting_notifier_destructed{});
+                if constexpr(!std::is_void_v<T>)return *this->value;
+                else return {};
             }
-            node* last_push(){
-                return the_end->last;
-            }
-            ~_notifier_slot_list(){
-                for(auto it=the_end->next,nit=it->next;it!=the_end;it=nit,nit=it->next){
-                    delete it;
-                }
-                delete the_end;
-            }
-            _notifier_slot_list(_notifier_slot_list&)=delete;
         };
+#endif
+    }
 
-        template<typename T>
-        void swap(_notifier_slot_list<T>&a,_notifier_slot_list<T>&b){
-            std::swap(a.the_end,b.the_end);
-        }
+    inline resume_policy current_resume_policy() noexcept{
+        return _detail::_run_queue::local().policy;
+    }
+
+    inline resume_policy set_resume_policy(resume_policy p) noexcept{
+        return std::exchange(_detail::_run_queue::local().policy,p);
     }
 
     template<typename T>
     struct notifier{
-        // list keep reference
+        // list of slots in frames of awaiting coroutines
         _detail::_notifier_slot_list<T> listener;
-        _detail::notifier_slot<T> &operator
+        _detail::notifier_slot<T> operator
         co_await (){
-            return listener.push();
+            return {listener};
+        }
+
+        _detail::_notifier_ref_slot<T> ref(){
+            return {listener};
+        }
+
+        _detail::_notifier_shared_slot<T> shared(){
+            return {listener};
         }
 
+#if __cpp_lib_expected
+        _detail::_notifier_checked_slot<T> checked(){
+            return {listener};
+        }
+#endif
+
         void notify(T &t){
-            decltype(listener) old;
-            swap(old,listener);
-            for(auto &a:old)
-                a.notify(t);
+            std::shared_ptr<const T> shared;
+            decltype(listener) old(std::move(listener));
+            auto &q=_detail::_run_queue::local();
+            if(q.policy==resume_policy::immediate){
+                std::size_t fanout=0;
+                for(;!old.empty();++fanout)
+                    old.pop().notify(t,shared);
+                _detail::_stats_notify(fanout);
+                return;
+            }
+            if(q.draining){ // waiters run after this returns, they need a copy
+                _detail::_stats_notify(old.empty()?0:defer(old,std::make_shared<const T>(t)));
+                return;
+            }
+            _detail::_stats_notify(enqueue(old,t,shared));
+            q.drain();
         }
 
         void notify(T &&t){
             notify(t);
         }
 
+        void notify_shared(std::shared_ptr<const T> p){
+            auto &t=const_cast<T &>(*p); // waiters only read it
+            decltype(listener) old(std::move(listener));
+            auto &q=_detail::_run_queue::local();
+            if(q.policy==resume_policy::immediate){
+                std::size_t fanout=0;
+                for(;!old.empty();++fanout)
+                    old.pop().notify(t,p);
+                _detail::_stats_notify(fanout);
+                return;
+            }
+            if(q.draining){
+                _detail::_stats_notify(defer(old,std::move(p)));
+                return;
+            }
+            _detail::_stats_notify(enqueue(old,t,p));
+            q.drain();
+        }
+
         ~notifier(){
-            for(auto &a:listener)
-                a.coroutine.resume();
+            while(!listener.empty())
+                listener.pop().resume();
         }
 
         notifier() = default;
@@ -492,26 +1414,74 @@ namespace chzn{
             swap(listener,t.listener);
             return *this;
         }
+
+    private:
+        // return how many are queued
+        static std::size_t enqueue(decltype(listener) &old,T &t,std::shared_ptr<const T> &shared) noexcept{
+            auto &q=_detail::_run_queue::local();
+            _detail::_slot_link *pos=&q.the_end;
+            std::size_t n=0;
+            for(;!old.empty();++n){
+                auto &slot=old.pop();
+                slot.value=&t;
+                slot.shared=&shared;
+                q.push(slot,pos);
+            }
+            return n;
+        }
+
+        static std::size_t defer(decltype(listener) &old,std::shared_ptr<const T> keep) noexcept{
+            auto &q=_detail::_run_queue::local();
+            _detail::_slot_link *pos=&q.the_end;
+            std::size_t n=0;
+            for(;!old.empty();++n){
+                auto &slot=old.pop();
+                slot.value=const_cast<T *>(keep.get());
+                slot.shared=nullptr;
+                slot.keep=keep;
+                q.push(slot,pos);
+            }
+            return n;
+        }
     };
 
     template<>
     struct notifier<void>{
         _detail::_notifier_slot_list<void> listener;
-        _detail::notifier_slot<void> &operator
+        _detail::notifier_slot<void> operator
         co_await (){
-            return listener.push();
+            return {listener};
+        }
+
+#if __cpp_lib_expected
+        _detail::_notifier_checked_slot<void> checked(){
+            return {listener};
         }
+#endif
 
         void notify(){
-            decltype(listener) old;
-            swap(old,listener);
-            for(auto &a:old)
-                a.notify();
+            decltype(listener) old(std::move(listener));
+            auto &q=_detail::_run_queue::local();
+            std::size_t fanout=0;
+            if(q.policy==resume_policy::immediate){
+                for(;!old.empty();++fanout)
+                    old.pop().notify();
+                _detail::_stats_notify(fanout);
+                return;
+            }
+            _detail::_slot_link *pos=&q.the_end;
+            for(;!old.empty();++fanout){
+                auto &slot=old.pop();
+                slot.value=reinterpret_cast<void *>(0xdedeaded);
+                q.push(slot,pos);
+            }
+            _detail::_stats_notify(fanout);
+            if(!q.draining)q.drain();
         }
 
         ~notifier(){
-            for(auto &a:listener)
-                a.coroutine.resume();
+            while(!listener.empty())
+                listener.pop().resume();
         }
 
         notifier() = default;
@@ -535,6 +1505,8 @@ namespace chzn{
 
         void return_value(T t){
             new(&value) T(std::move(t));
+            CHZN_ASYNC_WATCHDOG_NEST;
+            _detail::_coop_refill();
             return handle.resume();
         }
     };
@@ -544,6 +1516,8 @@ namespace chzn{
         std::coroutine_handle<> handle;
 
         void return_void() const{
+            CHZN_ASYNC_WATCHDOG_NEST;
+            _detail::_coop_refill();
             return handle.resume();
         }
     };
@@ -615,6 +1589,8 @@ namespace chzn{
 #include <stdexcept>
 namespace chzn{
     struct task;
+    template<typename T>
+    struct concurrent_notifier;
     namespace _detail{
         template<typename T,bool keep>
         struct _task_transformed_async{
@@ -629,8 +1605,16 @@ namespace chzn{
                 constexpr suspend_final final_suspend() const noexcept{return {};}
 
                 template<typename U>
-                promise_type(U &u,void(*&cancel_func_ref)(void*)){cancel_func_ptr=&cancel_func_ref;}
+                promise_type(U &u,void(*&cancel_func_ref)(void*),_frame_allocator_ref){cancel_func_ptr=&cancel_func_ref;}
                 void(**cancel_func_ptr)(void*);
+
+                using _frame_memory::operator new;
+
+                // frame use the allocator of the task
+                template<typename U>
+                static void *operator new(std::size_t size,U &,void(*&)(void*),_frame_allocator_ref alloc){
+                    return alloc.allocate(size);
+                }
             };
 
             using handle_type=std::coroutine_handle<promise_type>;
@@ -638,15 +1622,19 @@ namespace chzn{
 
             struct awaiter{
                 handle_type coroutine;
+                [[no_unique_address]] mutable _await_probe probe{};
 
                 bool await_ready() const noexcept{return coroutine.done();}
 
-                auto await_suspend(std::coroutine_handle<> handle) const noexcept{
+                template<typename P>
+                auto await_suspend(std::coroutine_handle<P> handle) const noexcept{
+                    probe.suspend(handle.address(),_type_name<_task_transformed_async>(),_where_of(handle));
                     coroutine.promise().await_by=handle;
                     return coroutine;
                 }
 
                 T await_resume() const{
+                    probe.resume();
                     if(coroutine.promise().state==_detail::throws)
                         std::rethrow_exception(coroutine.promise().error);
                     if constexpr(!std::is_same_v<T,void>)return std::move(reinterpret_cast<T &>(coroutine.promise().value));
@@ -678,13 +1666,70 @@ namespace chzn{
             friend task;
 
             template<typename U>
-            static _task_transformed_async<T,keep> transform(U u,void(*&cancel_func)(void*)){
+            static _task_transformed_async<T,keep> transform(U u,void(*&cancel_func)(void*),_frame_allocator_ref){
                 co_return co_await u;
             }
+        };
+
+        // awaiter which can be canceled in place, after await_cancel() it never resumes the coroutine
+        template<typename A>
+        concept _cancelable_awaiter=requires(A &a){
+            a.await_cancel();
+        };
+
+        // cancelable awaiter in task frame, registered as the cancel slot of the task, no extra frame
+        // A is a reference for lvalue awaiters
+        template<typename A>
+        struct _task_cancel_awaiter{
+            static constexpr bool traced=!requires{std::remove_reference_t<A>::self_traced;}; // or it has a probe itself
+
+            A awaiter;
+            void(*&cancel_func)(void*);
+            void *&cancel_token;
+            [[no_unique_address]] _await_probe probe{};
+
+            bool await_ready(){return awaiter.await_ready();}
+
+            // register first, awaiter may be resumed by other thread before await_suspend returns
+            template<typename P>
+            auto await_suspend(std::coroutine_handle<P> handle){
+                if constexpr(traced)probe.suspend(handle.address(),_type_name<std::remove_reference_t<A>>(),_where_of(handle));
+                cancel_token=std::addressof(awaiter);
+                cancel_func=[](void *token){static_cast<std::remove_reference_t<A> *>(token)->await_cancel();};
+                return awaiter.await_suspend(handle);
+            }
 
-            template<typename U>
-            static _task_transformed_async<T,keep> transform(_detail::notifier_slot<U> &u,void(*&cancel_func)(void*)){
-                co_return co_await u;
+            decltype(auto) await_resume(){
+                probe.resume();
+                cancel_func=nullptr;
+                return awaiter.await_resume();
+            }
+        };
+
+        // co_await async in task, cancel detach it, it destroys itself when done
+        template<typename T>
+        struct _task_async_awaiter{
+            static constexpr bool self_traced=true;
+
+            async<T> child;
+            [[no_unique_address]] mutable _await_probe probe{};
+
+            bool await_ready() const noexcept{return child.coroutine.done();}
+
+            template<typename P>
+            auto await_suspend(std::coroutine_handle<P> handle) const noexcept{
+                probe.suspend(handle.address(),_type_name<async<T>>(),_where_of(handle));
+                child.coroutine.promise().await_by=handle;
+                return child.coroutine;
+            }
+
+            T await_resume() const{
+                probe.resume();
+                return typename async<T>::awaiter{child.coroutine}.await_resume();
+            }
+
+            void await_cancel() noexcept{
+                std::exchange(child.coroutine,nullptr).promise().join.store(&_join_detached,std::memory_order_release);
             }
         };
 
@@ -729,43 +1774,72 @@ namespace chzn{
     };
     struct task{
         struct promise_type:public async<void>::promise_type{
-            task get_return_object(){return {handle_type::from_promise(*this)};}
+            task get_return_object(_detail::_where where={}){
+                this->where=where;
+                auto handle=handle_type::from_promise(*this);
+                CHZN_ASYNC_TRACE_EVENT(first_resume,handle.address(),nullptr); // runs at once
+#ifdef CHZN_ASYNC_WATCHDOG
+                _detail::_watchdog_resume(handle.address(),&this->where,"initial_suspend");
+#endif
+                return {handle};
+            }
 
             constexpr std::suspend_never initial_suspend()const noexcept{return {};}
 
-            constexpr std::suspend_always final_suspend() const noexcept{return {};}
+            constexpr _detail::_final_suspend final_suspend() const noexcept{return {};}
 
             void(*cancel_func)(void*)=nullptr;
             void* cancel_token=nullptr;
+            _detail::_frame_allocator_ref frame_allocator;
+
+            promise_type() = default;
 
+            template<typename Alloc,typename...Args>
+            promise_type(std::allocator_arg_t,const Alloc &alloc,const Args &...):frame_allocator(alloc){}
+
+            template<typename This,typename Alloc,typename...Args>
+            promise_type(const This &,std::allocator_arg_t,const Alloc &alloc,const Args &...):frame_allocator(alloc){}
+
+            // awaiter with await_cancel() (notifier, timer, channel...) is canceled in place,
+            // others are wrapped in a frame, cancel() make it not resume this
             template<typename U>
             auto await_transform(U &&u){
-                auto t=_detail::_task_transformed_async<typename _detail::_co_await_T<U>::type,true>::transform(std::forward<U>(u),cancel_func);
-                cancel_token=&t.coroutine.promise();
-                cancel_func=[](void *token){(decltype(&t.coroutine.promise())(token))->await_by=std::noop_coroutine();(decltype(&t.coroutine.promise())(token))->cancel_func_ptr=nullptr;};
-                return t;
+                if constexpr(_detail::_cancelable_awaiter<std::remove_reference_t<U>>)
+                    return _detail::_task_cancel_awaiter<U>{std::forward<U>(u),cancel_func,cancel_token};
+                else if constexpr(requires{{std::forward<U>(u).operator co_await()}->_detail::_cancelable_awaiter;})
+                    return _detail::_task_cancel_awaiter<decltype(std::forward<U>(u).operator co_await())>{std::forward<U>(u).operator co_await(),cancel_func,cancel_token};
+                else{
+                    auto t=_detail::_task_transformed_async<typename _detail::_co_await_T<U>::type,true>::transform(std::forward<U>(u),cancel_func,frame_allocator);
+                    cancel_token=&t.coroutine.promise();
+                    cancel_func=[](void *token){(decltype(&t.coroutine.promise())(token))->await_by=std::noop_coroutine();(decltype(&t.coroutine.promise())(token))->cancel_func_ptr=nullptr;};
+                    return t;
+                }
             }
 
             template<typename U>
-            auto await_transform(notifier<U> &u){
-                auto &t=u.operator co_await();
-                cancel_token=u.listener.last_push();
-                cancel_func=[](void *token){((decltype(u.listener.last_push()))token)->erase();};
-                return _detail::_task_transformed_async<typename _detail::_co_await_T<decltype(t)>::type,false>::transform(t,cancel_func);
+            _detail::_task_cancel_awaiter<_detail::_task_async_awaiter<U>> await_transform(async<U> &&u){
+                return {{std::move(u)},cancel_func,cancel_token};
+            }
+
+            // slot is kept in the task frame, cancel() marks its node in the stack
+            template<typename U>
+            auto await_transform(concurrent_notifier<U> &u){
+                return await_transform(u.operator co_await());
             }
 
             std::suspend_always await_transform(std::suspend_always){cancel_func=_detail::noop_cancel_func;return {};}
+
+            void cancel(){
+                if(!cancel_func)[[unlikely]]CHZN_ASYNC_THROW(cancel_running_task_error());
+                cancel_func(cancel_token);
+                cancel_func=_detail::noop_cancel_func;
+            }
         };
 
         using handle_type=std::coroutine_handle<promise_type>;
         handle_type coroutine;
 
-        void cancel(){
-            auto &t=coroutine.promise().cancel_func;
-            if(!t)[[unlikely]]throw cancel_running_task_error();
-            t(coroutine.promise().cancel_token);
-            t=_detail::noop_cancel_func;
-        }
+        void cancel(){coroutine.promise().cancel();}
 
         ~task(){
             if(!coroutine.operator bool())[[unlikely]]return;
@@ -789,4 +1863,4556 @@ namespace chzn{
     };
 }
 
-#endif
\ No newline at end of file
+/*
+ * version 1.3.0 Executor
+ * 2026/10/16
+ * type:
+ * - chzn::executor
+ *   usage:
+ *   - type erased reference to something which can resume coroutines, such as a thread running event loop;
+ *   - empty executor resume coroutine inline;
+ *   - copyable, compare by value;
+ *   member function:
+ *   - post(std::coroutine_handle<> handle)
+ *     resume handle in this executor, thread safe;
+ * - chzn::concurrent_notifier<T>
+ *   usage:
+ *   - same as chzn::notifier<T>, but can be co_awaited and notified from any thread;
+ *   - co_await push a node of the slot to lock free stack, notify swap out the whole stack;
+ *   - task::cancel() of a task co_awaiting it is O(1) and frees the task frame at once,
+ *     the node is skipped and freed by the next notify or the destructor;
+ *   - waiter is resumed by the executor current when it co_await, resume inline if there is none;
+ *   - T is copyable, every waiter get its own copy;
+ * function:
+ * - chzn::current_executor()
+ *   get executor of current thread;
+ * - chzn::set_current_executor(executor e)
+ *   set executor of current thread, return the old one, called by threads running event loop;
+ * */
+namespace chzn{
+    struct executor{
+        void *context=nullptr;
+        void (*post_func)(void *,std::coroutine_handle<>)=nullptr;
+
+        void post(std::coroutine_handle<> handle) const{
+            if(post_func)post_func(context,handle);
+            else{
+                CHZN_ASYNC_WATCHDOG_NEST;
+                _detail::_coop_refill();
+                handle.resume();
+            }
+        }
+
+        explicit operator bool() const noexcept{return post_func;}
+
+        bool operator==(const executor &) const = default;
+    };
+
+    namespace _detail{
+        inline executor &_current_executor() noexcept{
+            thread_local executor e;
+            return e;
+        }
+    }
+
+    inline executor current_executor() noexcept{
+        return _detail::_current_executor();
+    }
+
+    inline executor set_current_executor(executor e) noexcept{
+        std::swap(e,_detail::_current_executor());
+        return e;
+    }
+
+    namespace _detail{
+        template<typename T>
+        struct _concurrent_notifier_base;
+
+        struct _concurrent_slot_base;
+
+        // node of the lock free stack, kept off the awaiting frame so that a canceled task frees its frame at once,
+        // the first of notify and cancel to set claimed wins, notify_all frees the node in both cases
+        struct _concurrent_node{
+            _concurrent_node *next=nullptr;
+            _concurrent_slot_base *slot;
+            std::atomic<bool> claimed=false;
+
+#ifndef CHZN_ASYNC_NO_FRAME_POOL
+            static void *operator new(std::size_t size){return _frame_pool::allocate(size);}
+
+            static void operator delete(void *ptr,std::size_t size) noexcept{_frame_pool::deallocate(ptr,size);}
+#endif
+        };
+
+        struct _concurrent_slot_base{
+            std::atomic<_concurrent_node *> *head;
+            _concurrent_node *node=nullptr;
+            std::coroutine_handle<> coroutine;
+            executor home;
+            coroutine_state state=awaiting;
+
+            explicit _concurrent_slot_base(std::atomic<_concurrent_node *> *head) noexcept:head(head){}
+
+            bool await_ready() const noexcept{return false;}
+
+            // after push, other thread may resume and destroy this at once, so push is the last step
+            void await_suspend(std::coroutine_handle<> handle){
+                coroutine=handle;
+                home=current_executor();
+                node=new _concurrent_node{.slot=this};
+                node->next=head->load(std::memory_order_relaxed);
+                while(!head->compare_exchange_weak(node->next,node,std::memory_order_release,std::memory_order_relaxed));
+            }
+
+            // O(1), the node stays in the stack until the next notify, which skips and frees it
+            void await_cancel() noexcept{
+                node->claimed.store(true,std::memory_order_relaxed);
+            }
+        };
+
+        template<typename T>
+        struct _concurrent_slot:public _concurrent_slot_base{
+            using _concurrent_slot_base::_concurrent_slot_base;
+
+            alignas(T) std::byte value[sizeof(T)];
+
+            T await_resume(){
+                if(state!=returned)[[unlikely]]CHZN_ASYNC_THROW(awaiting_notifier_destructed{});
+                return std::move(reinterpret_cast<T &>(value));
+            }
+
+            ~_concurrent_slot(){
+                if(state==returned)reinterpret_cast<T &>(value).~T();
+            }
+        };
+
+        template<>
+        struct _concurrent_slot<void>:public _concurrent_slot_base{
+            using _concurrent_slot_base::_concurrent_slot_base;
+
+            void await_resume() const{
+                if(state!=returned)[[unlikely]]CHZN_ASYNC_THROW(awaiting_notifier_destructed{});
+            }
+        };
+
+        template<typename T>
+        struct _concurrent_notifier_base{
+            std::atomic<_concurrent_node *> head=nullptr;
+
+            _concurrent_slot<T> operator
+            co_await (){
+                return _concurrent_slot<T>(&head);
+            }
+
+            // swap out the whole stack, then resume in the order of co_await, skipping canceled ones
+            template<typename F>
+            void notify_all(F set){
+                _concurrent_node *node=head.exchange(nullptr,std::memory_order_acquire),*reversed=nullptr;
+                while(node){
+                    auto next=node->next;
+                    node->next=reversed;
+                    reversed=node;
+                    node=next;
+                }
+                while(reversed){
+                    auto next=reversed->next;
+                    auto slot=reversed->claimed.exchange(true,std::memory_order_relaxed)?nullptr:reversed->slot;
+                    delete reversed;
+                    if(slot){ // slot may be destroyed after post
+                        set(static_cast<_concurrent_slot<T> &>(*slot));
+                        slot->home.post(slot->coroutine);
+                    }
+                    reversed=next;
+                }
+            }
+
+            _concurrent_notifier_base() = default;
+
+            _concurrent_notifier_base(_concurrent_notifier_base &) = delete;
+
+            void operator=(_concurrent_notifier_base &) = delete;
+
+            ~_concurrent_notifier_base(){
+                notify_all([](_concurrent_slot<T> &){});
+            }
+        };
+    }
+
+    template<typename T>
+    struct concurrent_notifier:public _detail::_concurrent_notifier_base<T>{
+        void notify(const T &t){
+            this->notify_all([&](_detail::_concurrent_slot<T> &slot){
+                new(&slot.value) T(t);
+                slot.state=_detail::returned;
+            });
+        }
+    };
+
+    template<>
+    struct concurrent_notifier<void>:public _detail::_concurrent_notifier_base<void>{
+        void notify(){
+            notify_all([](_detail::_concurrent_slot<void> &slot){
+                slot.state=_detail::returned;
+            });
+        }
+    };
+}
+
+/*
+ * version 1.4.0 Thread Pool
+ * 2026/10/16
+ * type:
+ * - chzn::thread_pool
+ *   usage:
+ *   - executor with fixed number of worker threads;
+ *   - every worker has a Chase-Lev deque, coroutines posted by a worker are pushed to its own deque,
+ *     posted by other threads are pushed to a shared queue;
+ *   - idle worker steal from other workers, then park until new work posted;
+ *   - destruct wait workers run out of all posted work, then join them;
+ *   - not copyable, not movable;
+ *   member function:
+ *   - thread_pool(std::size_t threads=std::thread::hardware_concurrency())
+ *   - get_executor()
+ *     get chzn::executor of this pool, it is also current executor of workers;
+ *   - post(std::coroutine_handle<> handle)
+ *     resume handle in a worker, thread safe;
+ *   - schedule()
+ *     co_await pool.schedule() to continue in a worker of pool;
+ *   - size()
+ *     number of workers;
+ * function:
+ * - chzn::resume_on(executor e)
+ *   co_await resume_on(e) to continue in e, do nothing if e is empty or already current executor;
+ * */
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <deque>
+#include <cstdint>
+namespace chzn{
+    namespace _detail{
+        // Chase-Lev deque, owner push and pop at bottom, thieves steal at top
+        // "Correct and Efficient Work-Stealing for Weak Memory Models", Le et al. 2013
+        struct _work_stealing_deque{
+            struct array{
+                std::int64_t capacity;
+                std::atomic<void *> *data;
+                array *previous; // thieves may still read old arrays, free them at destruction
+
+                array(std::int64_t capacity,array *previous)
+                        :capacity(capacity),data(new std::atomic<void *>[capacity]),previous(previous){}
+
+                ~array(){delete[] data;}
+
+                void *get(std::int64_t i) const noexcept{
+                    return data[i&(capacity-1)].load(std::memory_order_relaxed);
+                }
+
+                void put(std::int64_t i,void *v) noexcept{
+                    data[i&(capacity-1)].store(v,std::memory_order_relaxed);
+                }
+            };
+
+            alignas(64) std::atomic<std::int64_t> top=0;
+            alignas(64) std::atomic<std::int64_t> bottom=0;
+            std::atomic<array *> buffer;
+
+            _work_stealing_deque():_work_stealing_deque(1024){}
+
+            explicit _work_stealing_deque(std::int64_t capacity):buffer(new array(capacity,nullptr)){}
+
+            ~_work_stealing_deque(){
+                for(auto a=buffer.load(std::memory_order_relaxed);a;){
+                    auto previous=a->previous;
+                    delete a;
+                    a=previous;
+                }
+            }
+
+            void push(void *v){
+                auto b=bottom.load(std::memory_order_relaxed);
+                auto t=top.load(std::memory_order_acquire);
+                auto a=buffer.load(std::memory_order_relaxed);
+                if(b-t>a->capacity-1)[[unlikely]]{
+                    auto bigger=new array(a->capacity*2,a);
+                    for(auto i=t;i<b;++i)bigger->put(i,a->get(i));
+                    buffer.store(bigger,std::memory_order_release);
+                    a=bigger;
+                }
+                a->put(b,v);
+                bottom.store(b+1,std::memory_order_release);
+            }
+
+            void *pop() noexcept{
+                auto b=bottom.load(std::memory_order_relaxed)-1;
+                auto a=buffer.load(std::memory_order_relaxed);
+                bottom.store(b,std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto t=top.load(std::memory_order_relaxed);
+                void *v=nullptr;
+                if(t<=b){
+                    v=a->get(b);
+                    if(t==b){ // last one, race with thieves
+                        if(!top.compare_exchange_strong(t,t+1,std::memory_order_seq_cst,std::memory_order_relaxed))
+                            v=nullptr;
+                        bottom.store(b+1,std::memory_order_relaxed);
+                    }
+                }else bottom.store(b+1,std::memory_order_relaxed);
+                return v;
+            }
+
+            void *steal() noexcept{
+                auto t=top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto b=bottom.load(std::memory_order_acquire);
+                if(t>=b)return nullptr;
+                auto a=buffer.load(std::memory_order_acquire);
+                auto v=a->get(t);
+                if(!top.compare_exchange_strong(t,t+1,std::memory_order_seq_cst,std::memory_order_relaxed))
+                    return nullptr;
+                return v;
+            }
+        };
+    }
+
+    struct thread_pool{
+        struct worker{
+            thread_pool *pool;
+            _detail::_work_stealing_deque deque;
+            std::uint32_t random;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<worker>> workers;
+        std::mutex inject_mutex;
+        std::deque<std::coroutine_handle<>> inject;
+        std::atomic<std::size_t> inject_size=0;
+        std::atomic<std::uint32_t> epoch=0; // bumped to wake parked workers
+        std::atomic<std::size_t> sleeping=0;
+        std::atomic<bool> stopping=false;
+
+        explicit thread_pool(std::size_t threads=std::thread::hardware_concurrency()){
+            if(threads==0)threads=1;
+            workers.reserve(threads);
+            for(std::size_t i=0;i<threads;++i)
+                workers.emplace_back(new worker{this,{},static_cast<std::uint32_t>(i*2654435761u+1),{}});
+            for(auto &w:workers)
+                w->thread=std::thread([this,w=w.get()]{run(*w);});
+        }
+
+        thread_pool(thread_pool &) = delete;
+
+        void operator=(thread_pool &) = delete;
+
+        ~thread_pool(){
+            stopping.store(true,std::memory_order_seq_cst);
+            epoch.fetch_add(1,std::memory_order_seq_cst);
+            epoch.notify_all();
+            for(auto &w:workers)w->thread.join();
+        }
+
+        std::size_t size() const noexcept{return workers.size();}
+
+        executor get_executor() noexcept{
+            return {this,[](void *pool,std::coroutine_handle<> handle){static_cast<thread_pool *>(pool)->post(handle);}};
+        }
+
+        void post(std::coroutine_handle<> handle){
+            auto w=current_worker();
+            if(w&&w->pool==this)w->deque.push(handle.address());
+            else{
+                std::lock_guard lock(inject_mutex);
+                inject.push_back(handle);
+                inject_size.fetch_add(1,std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(sleeping.load(std::memory_order_relaxed)){
+                epoch.fetch_add(1,std::memory_order_relaxed);
+                epoch.notify_one();
+            }
+        }
+
+        struct schedule_awaiter{
+            thread_pool *pool;
+
+            static constexpr bool await_ready() noexcept{return false;}
+
+            void await_suspend(std::coroutine_handle<> handle) const{pool->post(handle);}
+
+            static constexpr void await_resume() noexcept{}
+        };
+
+        schedule_awaiter schedule() noexcept{return {this};}
+
+    private:
+        static worker *&current_worker() noexcept{
+            thread_local worker *w=nullptr;
+            return w;
+        }
+
+        void *find_work(worker &self) noexcept{
+            if(auto v=self.deque.pop())return v;
+            if(inject_size.load(std::memory_order_relaxed)){
+                std::lock_guard lock(inject_mutex);
+                if(!inject.empty()){
+                    auto h=inject.front();
+                    inject.pop_front();
+                    inject_size.fetch_sub(1,std::memory_order_relaxed);
+                    return h.address();
+                }
+            }
+            // xorshift to pick the first victim
+            self.random^=self.random<<13;
+            self.random^=self.random>>17;
+            self.random^=self.random<<5;
+            auto n=workers.size();
+            for(std::size_t i=0,start=self.random%n;i<n;++i){
+                auto &victim=*workers[(start+i)%n];
+                if(&victim==&self)continue;
+                if(auto v=victim.deque.steal())return v;
+            }
+            return nullptr;
+        }
+
+        void run(worker &self){
+            current_worker()=&self;
+            set_current_executor(get_executor());
+            for(;;){
+                if(auto v=find_work(self)){
+                    CHZN_ASYNC_WATCHDOG_NEST;
+                    _detail::_coop_refill();
+                    std::coroutine_handle<>::from_address(v).resume();
+                    continue;
+                }
+                auto e=epoch.load(std::memory_order_seq_cst);
+                sleeping.fetch_add(1,std::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                // check again, a post before sleeping was counted could be missed
+                if(auto v=find_work(self)){
+                    sleeping.fetch_sub(1,std::memory_order_relaxed);
+                    CHZN_ASYNC_WATCHDOG_NEST;
+                    _detail::_coop_refill();
+                    std::coroutine_handle<>::from_address(v).resume();
+                    continue;
+                }
+                if(stopping.load(std::memory_order_seq_cst)){
+                    sleeping.fetch_sub(1,std::memory_order_relaxed);
+                    break;
+                }
+                epoch.wait(e,std::memory_order_seq_cst);
+                sleeping.fetch_sub(1,std::memory_order_relaxed);
+            }
+            set_current_executor({});
+            current_worker()=nullptr;
+        }
+    };
+
+    namespace _detail{
+        struct _resume_on_awaiter{
+            executor e;
+
+            bool await_ready() const noexcept{return !e||e==current_executor();}
+
+            void await_suspend(std::coroutine_handle<> handle) const{e.post(handle);}
+
+            static constexpr void await_resume() noexcept{}
+        };
+    }
+
+    inline _detail::_resume_on_awaiter resume_on(executor e) noexcept{return {e};}
+}
+
+/*
+ * version 1.4.1 Shard Runtime
+ * 2026/10/16
+ * type:
+ * - chzn::shard_runtime
+ *   usage:
+ *   - one event loop thread per shard, shard n is pinned to cpu n (linux only), nothing is shared between shards;
+ *   - every ordered pair of shards has a bounded SPSC ring, coroutines hop between shards through them;
+ *     when a ring is full, the message waits in the sending shard and is retried in next loop iteration;
+ *   - threads out of runtime post to a shard through its locked inbox;
+ *   - destruct wait shards run out of all posted work, then join them,
+ *     work posted to a shard after it exited is run in the destructing thread as that shard;
+ *   - not copyable, not movable;
+ *   member function:
+ *   - shard_runtime(std::size_t shards=std::thread::hardware_concurrency(),std::size_t ring_capacity=1024,bool pin_cpu=true)
+ *   - get_executor(std::size_t n)
+ *     get chzn::executor of shard n, it is also current executor of shard n;
+ *   - post(std::size_t n,std::coroutine_handle<> handle)
+ *     resume handle in shard n, thread safe;
+ *   - on_shard(std::size_t n,F fn)
+ *     same as chzn::on_shard, can be used out of runtime;
+ *   - size()
+ *     number of shards;
+ * function:
+ * - chzn::on_shard(std::size_t n,F fn)
+ *   return chzn::async<R>, co_await it to run fn() in shard n of current runtime, then back to current executor;
+ *   fn returns R or chzn::async<R>;
+ * - chzn::this_shard()
+ *   index of current shard, or chzn::shard_runtime::npos out of runtime;
+ * */
+#include <optional>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+namespace chzn{
+    namespace _detail{
+        // bounded single producer single consumer ring
+        struct _spsc_ring{
+            std::size_t mask;
+            std::unique_ptr<void *[]> slots;
+            alignas(64) std::atomic<std::size_t> head=0; // consumer
+            std::size_t cached_tail=0;
+            alignas(64) std::atomic<std::size_t> tail=0; // producer
+            std::size_t cached_head=0;
+
+            explicit _spsc_ring(std::size_t capacity){
+                std::size_t c=1;
+                while(c<capacity)c<<=1;
+                mask=c-1;
+                slots.reset(new void *[c]);
+            }
+
+            bool push(void *v) noexcept{
+                auto t=tail.load(std::memory_order_relaxed);
+                if(t-cached_head>mask){
+                    cached_head=head.load(std::memory_order_acquire);
+                    if(t-cached_head>mask)return false;
+                }
+                slots[t&mask]=v;
+                tail.store(t+1,std::memory_order_release);
+                return true;
+            }
+
+            void *pop() noexcept{
+                auto h=head.load(std::memory_order_relaxed);
+                if(h==cached_tail){
+                    cached_tail=tail.load(std::memory_order_acquire);
+                    if(h==cached_tail)return nullptr;
+                }
+                auto v=slots[h&mask];
+                head.store(h+1,std::memory_order_release);
+                return v;
+            }
+
+            bool empty() const noexcept{
+                return head.load(std::memory_order_relaxed)==tail.load(std::memory_order_acquire);
+            }
+        };
+
+        template<typename T>
+        struct _is_async:std::false_type{
+        };
+
+        template<typename T>
+        struct _is_async<async<T>>:std::true_type{
+        };
+
+        template<typename F>
+        struct _shard_result{
+            using type=std::invoke_result_t<F &>;
+        };
+
+        template<typename F> requires _is_async<std::invoke_result_t<F &>>::value
+        struct _shard_result<F>{
+            using type=_co_await_T<std::invoke_result_t<F &>>::type;
+        };
+    }
+
+    struct shard_runtime{
+        static constexpr std::size_t npos=-1;
+
+        struct shard{
+            shard_runtime *runtime;
+            std::size_t index;
+            std::deque<std::coroutine_handle<>> ready;
+            std::vector<std::deque<void *>> overflow; // messages to other shards whose rings are full
+            std::size_t overflow_size=0;
+            std::mutex inbox_mutex;
+            std::vector<std::coroutine_handle<>> inbox;
+            std::atomic<bool> inbox_nonempty=false;
+            std::atomic<std::uint32_t> epoch=0;
+            std::atomic<bool> sleeping=false;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<shard>> shards;
+        std::vector<std::unique_ptr<_detail::_spsc_ring>> rings; // rings[from*size()+to]
+        std::atomic<bool> stopping=false;
+
+        explicit shard_runtime(std::size_t n=std::thread::hardware_concurrency(),std::size_t ring_capacity=1024,bool pin_cpu=true){
+            if(n==0)n=1;
+            shards.reserve(n);
+            rings.reserve(n*n);
+            for(std::size_t i=0;i<n*n;++i)
+                rings.emplace_back(i/n==i%n?nullptr:new _detail::_spsc_ring(ring_capacity));
+            for(std::size_t i=0;i<n;++i){
+                auto &s=*shards.emplace_back(new shard);
+                s.runtime=this;
+                s.index=i;
+                s.overflow.resize(n);
+            }
+            for(auto &s:shards){
+                s->thread=std::thread([this,s=s.get()]{run(*s);});
+#if defined(__linux__)
+                if(pin_cpu){
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    CPU_SET(s->index%CPU_SETSIZE,&set);
+                    pthread_setaffinity_np(s->thread.native_handle(),sizeof(set),&set); // best effort
+                }
+#endif
+            }
+        }
+
+        shard_runtime(shard_runtime &) = delete;
+
+        void operator=(shard_runtime &) = delete;
+
+        ~shard_runtime(){
+            stopping.store(true,std::memory_order_seq_cst);
+            for(auto &s:shards)wake(*s);
+            for(auto &s:shards)s->thread.join();
+            // hops to a shard that had already exited, run them in this thread as that shard
+            for(bool more=true;more;){
+                more=false;
+                for(auto &s:shards)more|=drain(*s);
+            }
+        }
+
+        std::size_t size() const noexcept{return shards.size();}
+
+        executor get_executor(std::size_t n) noexcept{
+            return {shards[n].get(),[](void *s,std::coroutine_handle<> handle){
+                auto &target=*static_cast<shard *>(s);
+                target.runtime->post(target.index,handle);
+            }};
+        }
+
+        void post(std::size_t n,std::coroutine_handle<> handle){
+            auto &target=*shards[n];
+            auto from=current_shard();
+            if(from==&target){
+                target.ready.push_back(handle);
+                return;
+            }
+            if(from&&from->runtime==this){
+                auto &pending=from->overflow[n];
+                if(!pending.empty()||!ring(from->index,n).push(handle.address())){
+                    pending.push_back(handle.address());
+                    ++from->overflow_size;
+                    return;
+                }
+            }else{
+                std::lock_guard lock(target.inbox_mutex);
+                target.inbox.push_back(handle);
+                target.inbox_nonempty.store(true,std::memory_order_relaxed);
+            }
+            wake_if_sleeping(target);
+        }
+
+        template<typename F>
+        auto on_shard(std::size_t n,F fn){
+            return hop_and_run<typename _detail::_shard_result<F>::type>(*this,n,std::move(fn));
+        }
+
+        static shard_runtime *current() noexcept{
+            auto s=current_shard();
+            return s?s->runtime:nullptr;
+        }
+
+        static std::size_t current_index() noexcept{
+            auto s=current_shard();
+            return s?s->index:npos;
+        }
+
+    private:
+        static shard *&current_shard() noexcept{
+            thread_local shard *s=nullptr;
+            return s;
+        }
+
+        _detail::_spsc_ring &ring(std::size_t from,std::size_t to) noexcept{
+            return *rings[from*shards.size()+to];
+        }
+
+        static void wake(shard &s){
+            s.epoch.fetch_add(1,std::memory_order_seq_cst);
+            s.epoch.notify_one();
+        }
+
+        static void wake_if_sleeping(shard &s){
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(s.sleeping.load(std::memory_order_relaxed))wake(s);
+        }
+
+        struct hop_awaiter{
+            shard_runtime *runtime;
+            std::size_t n;
+
+            bool await_ready() const noexcept{return current_shard()==runtime->shards[n].get();}
+
+            void await_suspend(std::coroutine_handle<> handle) const{runtime->post(n,handle);}
+
+            static constexpr void await_resume() noexcept{}
+        };
+
+        template<typename R,typename F>
+        static async<R> hop_and_run(shard_runtime &runtime,std::size_t n,F fn){
+            auto home=current_executor();
+            std::optional<std::conditional_t<std::is_void_v<R>,bool,R>> result;
+            std::exception_ptr error;
+            co_await hop_awaiter{&runtime,n};
+#if __cpp_exceptions
+            try{
+#endif
+                if constexpr(std::is_void_v<R>){
+                    if constexpr(_detail::_is_async<std::invoke_result_t<F &>>::value)co_await fn();
+                    else fn();
+                    result.emplace(true);
+                }else{
+                    if constexpr(_detail::_is_async<std::invoke_result_t<F &>>::value)result.emplace(co_await fn());
+                    else result.emplace(fn());
+                }
+#if __cpp_exceptions
+            }catch(...){
+                error=std::current_exception();
+            }
+#endif
+            co_await resume_on(home);
+            if(error)std::rethrow_exception(error);
+            if constexpr(!std::is_void_v<R>)co_return std::move(*result);
+        }
+
+        bool collect(shard &self){
+            bool got=false;
+            auto n=shards.size();
+            for(std::size_t from=0;from<n;++from){
+                if(from==self.index)continue;
+                auto &r=ring(from,self.index);
+                while(auto v=r.pop()){
+                    self.ready.push_back(std::coroutine_handle<>::from_address(v));
+                    got=true;
+                }
+            }
+            if(self.inbox_nonempty.load(std::memory_order_relaxed)){
+                std::vector<std::coroutine_handle<>> inbox;
+                {
+                    std::lock_guard lock(self.inbox_mutex);
+                    std::swap(inbox,self.inbox);
+                    self.inbox_nonempty.store(false,std::memory_order_relaxed);
+                }
+                for(auto h:inbox)self.ready.push_back(h);
+                got|=!inbox.empty();
+            }
+            return got;
+        }
+
+        void flush_overflow(shard &self){
+            for(std::size_t to=0;to<self.overflow.size()&&self.overflow_size;++to){
+                auto &pending=self.overflow[to];
+                bool pushed=false;
+                while(!pending.empty()&&ring(self.index,to).push(pending.front())){
+                    pending.pop_front();
+                    --self.overflow_size;
+                    pushed=true;
+                }
+                if(pushed)wake_if_sleeping(*shards[to]);
+            }
+        }
+
+        // run what is ready now, coroutines posted meanwhile wait for next iteration
+        static void run_ready(shard &self){
+            for(auto count=self.ready.size();count;--count){
+                auto h=self.ready.front();
+                self.ready.pop_front();
+                CHZN_ASYNC_WATCHDOG_NEST;
+                _detail::_coop_refill();
+                h.resume();
+            }
+        }
+
+        // after all shards exited, return true if self had work left
+        bool drain(shard &self){
+            auto previous=std::exchange(current_shard(),&self);
+            auto previous_executor=set_current_executor(get_executor(self.index));
+            bool work=self.overflow_size;
+            if(work)flush_overflow(self);
+            work|=collect(self)|!self.ready.empty();
+            while(!self.ready.empty())run_ready(self);
+            set_current_executor(previous_executor);
+            current_shard()=previous;
+            return work;
+        }
+
+        void run(shard &self){
+            current_shard()=&self;
+            set_current_executor(get_executor(self.index));
+            for(;;){
+                if(self.overflow_size)flush_overflow(self);
+                collect(self);
+                if(!self.ready.empty()){
+                    run_ready(self);
+                    continue;
+                }
+                if(self.overflow_size){
+                    if(stopping.load(std::memory_order_relaxed))break; // receiver may have exited, left to destructor
+                    std::this_thread::yield();
+                    continue;
+                }
+                auto e=self.epoch.load(std::memory_order_seq_cst);
+                self.sleeping.store(true,std::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if(collect(self)){
+                    self.sleeping.store(false,std::memory_order_relaxed);
+                    continue;
+                }
+                if(stopping.load(std::memory_order_seq_cst)){
+                    self.sleeping.store(false,std::memory_order_relaxed);
+                    break;
+                }
+                self.epoch.wait(e,std::memory_order_seq_cst);
+                self.sleeping.store(false,std::memory_order_relaxed);
+            }
+            set_current_executor({});
+            current_shard()=nullptr;
+        }
+    };
+
+    template<typename F>
+    inline auto on_shard(std::size_t n,F fn){
+        auto runtime=shard_runtime::current();
+        if(!runtime)[[unlikely]]CHZN_ASYNC_THROW(std::logic_error("chzn::on_shard called out of chzn::shard_runtime"));
+        return runtime->on_shard(n,std::move(fn));
+    }
+
+    inline std::size_t this_shard() noexcept{
+        return shard_runtime::current_index();
+    }
+}
+
+/*
+ * version 1.5.0 Combinators
+ * 2026/10/16
+ * function:
+ * - chzn::when_all(a...)
+ *   a is chzn::async<T> or chzn::notifier<T>&,
+ *   return chzn::async<std::tuple<R...>>, start all children at once, complete when all of them complete;
+ *   R is T, or std::monostate if T is void;
+ *   exception of first (in order of arguments) throwing child is rethrown;
+ * - chzn::when_all(range)
+ *   range of chzn::async<T>, return chzn::async<std::vector<T>>, or chzn::async<void> if T is void;
+ * - chzn::when_any(a...)
+ *   return chzn::async<std::variant<R...>>, complete when first child completes, index() is which one;
+ *   losers co_awaiting notifier are canceled, losers not started are destroyed,
+ *   others are detached, and destroy themselves when complete;
+ * - chzn::when_any(range)
+ *   return chzn::async<std::pair<std::size_t,T>>, or chzn::async<std::size_t> if T is void;
+ * notice:
+ * - children share one completion block in frame of the combinator, no frame or allocation per child
+ *   (range version allocate one vector);
+ * - async children may complete in any thread, notifier children are single thread as notifier;
+ * */
+#include <tuple>
+#include <variant>
+#include <ranges>
+namespace chzn{
+    namespace _detail{
+        template<typename T>
+        using _join_value_t=std::conditional_t<std::is_void_v<T>,std::monostate,T>;
+
+        template<typename T>
+        struct _join_async_child:public _join_child{
+            using value_type=T;
+            async<T> child;
+
+            _join_async_child(async<T> &&a):child(std::move(a)){}
+
+            void start(){
+                child.coroutine.promise().join.store(this,std::memory_order_relaxed);
+                child.coroutine.resume();
+            }
+
+            // return true if child is arriving at the block now, and must be waited
+            bool cancel() noexcept{
+                auto &join=child.coroutine.promise().join;
+                if(join.load(std::memory_order_relaxed)==nullptr){ // not started
+                    child.coroutine.destroy();
+                    child.coroutine=nullptr;
+                    return false;
+                }
+                auto state=join.exchange(&_join_detached,std::memory_order_acq_rel);
+                if(state==&_join_arriving)return true;
+                child.coroutine=nullptr; // it destroys itself when complete
+                return false;
+            }
+
+            T result(){
+                return typename async<T>::awaiter{child.coroutine}.await_resume();
+            }
+        };
+
+        template<typename T>
+        struct _join_notifier_child:public notifier_slot<T>,public _join_child{
+            using value_type=T;
+            std::optional<_join_value_t<T>> value;
+
+            _join_notifier_child(notifier<T> &n):notifier_slot<T>(n.listener){}
+
+            void start(){
+                this->on_notify=[](_notifier_slot_base &slot){
+                    auto &self=static_cast<_join_notifier_child &>(slot);
+                    if(self.notifier_slot<T>::value){
+                        if constexpr(std::is_void_v<T>)self.value.emplace();
+                        else self.value.emplace(*self.notifier_slot<T>::value);
+                    }
+                    self.arrive().resume();
+                };
+                this->list->push(*this);
+                _stats_waiters(1);
+            }
+
+            bool cancel() noexcept{
+                this->leave();
+                return false;
+            }
+
+            T result(){
+                if(!value)[[unlikely]]CHZN_ASYNC_THROW(awaiting_notifier_destructed{});
+                if constexpr(!std::is_void_v<T>)return std::move(*value);
+            }
+        };
+
+        template<typename T>
+        _join_async_child<T> _as_join_child(async<T> &&a){return {std::move(a)};}
+
+        template<typename T>
+        _join_notifier_child<T> _as_join_child(notifier<T> &n){return {n};}
+
+        template<typename C>
+        _join_value_t<typename C::value_type> _join_result(C &child){
+            if constexpr(std::is_void_v<typename C::value_type>){
+                child.result();
+                return {};
+            }else return child.result();
+        }
+
+        // start children in await_suspend, the starter hold one count until all started
+        template<typename F>
+        struct _join_awaiter{
+            _join &join;
+            F start;
+
+            static constexpr bool await_ready() noexcept{return false;}
+
+            bool await_suspend(std::coroutine_handle<> handle){
+                join.parent=handle;
+                start();
+                return join.count.fetch_sub(1,std::memory_order_acq_rel)!=1;
+            }
+
+            static constexpr void await_resume() noexcept{}
+        };
+
+        template<typename F>
+        _join_awaiter(_join &,F)->_join_awaiter<F>;
+
+        template<typename C>
+        void _join_attach(C &child,_join &join,std::size_t index){
+            child.join=&join;
+            child.index=index;
+        }
+
+        template<typename C>
+        bool _join_start_unless_won(C &child,_join &join){
+            if(join.any&&join.winner.load(std::memory_order_acquire)!=std::size_t(-1))return false;
+            child.start();
+            return true;
+        }
+
+        inline void _join_wait_losers(_join &join,std::size_t arriving) noexcept{
+            while(join.finished.load(std::memory_order_acquire)<arriving); // losers are only a few atomic operations away
+        }
+
+        template<typename...C>
+        async<std::tuple<_join_value_t<typename C::value_type>...>> _when_all(C...children){
+            _join join{sizeof...(C)+1};
+            std::size_t i=0;
+            (_join_attach(children,join,i++),...);
+            co_await _join_awaiter{join,[&]{(children.start(),...);}};
+            co_return std::tuple<_join_value_t<typename C::value_type>...>{_join_result(children)...};
+        }
+
+        template<std::size_t...I,typename...C>
+        async<std::variant<_join_value_t<typename C::value_type>...>> _when_any(std::index_sequence<I...>,C...children){
+            _join join{2};
+            join.any=true;
+            (_join_attach(children,join,I),...);
+            co_await _join_awaiter{join,[&]{(_join_start_unless_won(children,join)&&...);}};
+            auto winner=join.winner.load(std::memory_order_acquire);
+            std::size_t arriving=((I!=winner&&children.cancel())+...+0);
+            _join_wait_losers(join,arriving);
+            std::optional<std::variant<_join_value_t<typename C::value_type>...>> result;
+            ((I==winner?(result.emplace(std::in_place_index<I>,_join_result(children)),0):0),...);
+            co_return std::move(*result);
+        }
+
+        template<typename T>
+        using _when_all_range_t=std::conditional_t<std::is_void_v<T>,void,std::vector<_join_value_t<T>>>;
+
+        template<typename T>
+        using _when_any_range_t=std::conditional_t<std::is_void_v<T>,std::size_t,std::pair<std::size_t,_join_value_t<T>>>;
+
+        template<typename T>
+        async<_when_all_range_t<T>> _when_all_range(std::vector<_join_async_child<T>> children){
+            _join join{children.size()+1};
+            for(std::size_t i=0;i<children.size();++i)_join_attach(children[i],join,i);
+            co_await _join_awaiter{join,[&]{for(auto &c:children)c.start();}};
+            if constexpr(std::is_void_v<T>){
+                for(auto &c:children)c.result();
+            }else{
+                std::vector<T> result;
+                result.reserve(children.size());
+                for(auto &c:children)result.push_back(c.result());
+                co_return result;
+            }
+        }
+
+        template<typename T>
+        async<_when_any_range_t<T>> _when_any_range(std::vector<_join_async_child<T>> children){
+            if(children.empty())[[unlikely]]CHZN_ASYNC_THROW(std::invalid_argument("chzn::when_any of empty range"));
+            _join join{2};
+            join.any=true;
+            for(std::size_t i=0;i<children.size();++i)_join_attach(children[i],join,i);
+            co_await _join_awaiter{join,[&]{
+                for(auto &c:children)
+                    if(!_join_start_unless_won(c,join))break;
+            }};
+            auto winner=join.winner.load(std::memory_order_acquire);
+            std::size_t arriving=0;
+            for(std::size_t i=0;i<children.size();++i)
+                if(i!=winner)arriving+=children[i].cancel();
+            _join_wait_losers(join,arriving);
+            if constexpr(std::is_void_v<T>){
+                children[winner].result();
+                co_return winner;
+            }else co_return std::pair<std::size_t,T>{winner,children[winner].result()};
+        }
+
+        template<typename R>
+        auto _join_children(R &&range){
+            using T=_co_await_T<std::ranges::range_value_t<R>>::type;
+            std::vector<_join_async_child<T>> children;
+            if constexpr(std::ranges::sized_range<R>)children.reserve(std::ranges::size(range));
+            for(auto &&a:range)children.emplace_back(std::move(a));
+            return children;
+        }
+    }
+
+    template<typename...A> requires(sizeof...(A)>0)
+    auto when_all(A &&...a){
+        return _detail::_when_all(_detail::_as_join_child(std::forward<A>(a))...);
+    }
+
+    template<std::ranges::input_range R> requires _detail::_is_async<std::ranges::range_value_t<R>>::value
+    auto when_all(R &&range){
+        return _detail::_when_all_range(_detail::_join_children(range));
+    }
+
+    template<typename...A> requires(sizeof...(A)>0)
+    auto when_any(A &&...a){
+        return _detail::_when_any(std::index_sequence_for<A...>{},_detail::_as_join_child(std::forward<A>(a))...);
+    }
+
+    template<std::ranges::input_range R> requires _detail::_is_async<std::ranges::range_value_t<R>>::value
+    auto when_any(R &&range){
+        return _detail::_when_any_range(_detail::_join_children(range));
+    }
+}
+
+
+/*
+ * version 1.6.0 Timer
+ * 2026/10/16
+ * type:
+ * - chzn::timer_wheel
+ *   usage:
+ *   - hierarchical timing wheel, 4 levels of 256 slots, O(1) insert and cancel;
+ *   - timers are intrusive nodes in frames of sleeping coroutines, a wheel never allocate;
+ *   - deadlines are rounded up to ticks, a timer never fires early;
+ *   - single thread, timer_wheel constructed in a thread become current timer_wheel of the thread if there is none;
+ *   - chzn::io_context own one and drive it, or use run() / advance(now) to drive it yourself;
+ *   - not copyable, not movable;
+ *   member function:
+ *   - timer_wheel(std::chrono::steady_clock::duration tick=1ms)
+ *   - advance(time_point now=clock::now())
+ *     fire timers whose deadline <= now, return how many fired;
+ *   - next_expiry()
+ *     std::optional<time_point>, a time point not later than the first deadline, or nullopt if empty;
+ *   - run()
+ *     sleep and advance until empty;
+ *   - size()/empty()
+ *   static member function:
+ *   - current()
+ *     current timer_wheel of this thread, or nullptr;
+ * function:
+ * - chzn::sleep_for(duration d)
+ * - chzn::sleep_until(time_point tp)
+ *   co_await it to resume after d or at tp, by current timer_wheel;
+ *   throw std::logic_error if there is no current timer_wheel;
+ * - chzn::with_timeout(awaitable a,duration d)
+ *   return chzn::async<std::optional<T>>, or chzn::async<bool> if T is void, nullopt or false if timeout;
+ *   a is co_awaited by a chzn::task, when deadline fires, its pending await is canceled as task::cancel();
+ *   a is moved into the frame if it is rvalue, referenced if it is lvalue;
+ *   a must complete in the thread of current timer_wheel;
+ * changes:
+ * - cancel logic of chzn::task is in task::promise_type::cancel();
+ * */
+#include <chrono>
+#include <bit>
+namespace chzn{
+    namespace _detail{
+        struct _timer_node:public _slot_link{
+            std::uint64_t expiry=0; // in ticks
+            void(*fire)(_timer_node &)=nullptr;
+        };
+    }
+
+    struct timer_wheel{
+        using clock=std::chrono::steady_clock;
+
+        explicit timer_wheel(clock::duration tick=std::chrono::milliseconds(1)):tick(tick),start(clock::now()){
+            if(!current())current()=this;
+        }
+
+        timer_wheel(timer_wheel &) = delete;
+
+        void operator=(timer_wheel &) = delete;
+
+        ~timer_wheel(){
+            if(current()==this)current()=nullptr;
+            for(auto &level:slots)
+                for(auto &slot:level)
+                    while(slot.linked())slot.next->erase();
+        }
+
+        static timer_wheel *&current() noexcept{
+            thread_local timer_wheel *w=nullptr;
+            return w;
+        }
+
+        std::size_t size() const noexcept{return count;}
+
+        bool empty() const noexcept{return !count;}
+
+        // first tick not before tp
+        std::uint64_t to_tick(clock::time_point tp) const noexcept{
+            if(tp<=start)return 0;
+            return static_cast<std::uint64_t>(((tp-start)+tick-clock::duration(1))/tick);
+        }
+
+        void insert(_detail::_timer_node &n) noexcept{
+            ++count;
+            place(n);
+        }
+
+        void cancel(_detail::_timer_node &n) noexcept{
+            if(!n.linked())return;
+            n.erase();
+            --count;
+        }
+
+        std::size_t advance(clock::time_point now=clock::now()){
+            if(now<start)return 0;
+            auto target=static_cast<std::uint64_t>((now-start)/tick);
+            std::size_t fired=0;
+            while(next_tick<=target){
+                if(!count){
+                    next_tick=target+1;
+                    break;
+                }
+                if(!slots[0][next_tick&mask].linked()){ // skip to next tick with something to fire or cascade
+                    next_tick=std::max(next_tick,std::min(next_event(),target+1));
+                    if(next_tick>target)break;
+                }
+                fired+=process_tick();
+            }
+            return fired;
+        }
+
+        std::optional<clock::time_point> next_expiry() const noexcept{
+            if(!count)return std::nullopt;
+            return start+tick*static_cast<clock::rep>(next_event());
+        }
+
+        void run(){
+            auto previous=std::exchange(current(),this);
+            while(count){
+                std::this_thread::sleep_until(*next_expiry());
+                advance();
+            }
+            current()=previous;
+        }
+
+    private:
+        static constexpr unsigned bits=8,levels=4,slot_count=1u<<bits,mask=slot_count-1;
+
+        clock::duration tick;
+        clock::time_point start;
+        std::uint64_t next_tick=0; // first tick not processed
+        std::size_t count=0;
+        _detail::_slot_link slots[levels][slot_count];
+        std::uint64_t occupied[levels][slot_count/64]{}; // may be set for an empty slot, cleared when processed
+
+        // first tick which fires or cascades an occupied slot
+        std::uint64_t next_event() const noexcept{
+            auto best=~std::uint64_t(0);
+            for(unsigned level=0;level<levels;++level){
+                auto shift=bits*level;
+                auto index=static_cast<unsigned>((next_tick>>shift)&mask);
+                // slot of current index is cascaded unless next_tick is just at the boundary, then it is for next round
+                auto skip=next_tick&((std::uint64_t(1)<<shift)-1)?1u:0u;
+                auto d=next_occupied(level,(index+skip)&mask)+skip;
+                if(d>=slot_count+skip)continue;
+                best=std::min(best,((next_tick>>shift)+d)<<shift);
+            }
+            return best;
+        }
+
+        static void move_list(_detail::_slot_link &from,_detail::_slot_link &to) noexcept{
+            if(!from.linked())return;
+            to.next=from.next;
+            to.last=from.last;
+            to.next->last=&to;
+            to.last->next=&to;
+            from.last=from.next=&from;
+        }
+
+        void place(_detail::_timer_node &n) noexcept{
+            auto delta=n.expiry>next_tick?n.expiry-next_tick:0;
+            unsigned level=0;
+            while(level+1<levels&&delta>>(bits*(level+1)))++level;
+            auto shift=bits*level;
+            // too far, wait in the slot cascaded last and be placed again
+            auto index=delta>>(bits*levels)?(next_tick>>shift)&mask:(std::max(n.expiry,next_tick)>>shift)&mask;
+            auto &slot=slots[level][index];
+            n.last=slot.last;
+            n.next=&slot;
+            slot.last->next=&n;
+            slot.last=&n;
+            occupied[level][index/64]|=std::uint64_t(1)<<(index%64);
+        }
+
+        // distance from `from` to first occupied slot, circular, slot_count if none
+        unsigned next_occupied(unsigned level,unsigned from) const noexcept{
+            for(unsigned d=0;d<slot_count;){
+                auto i=(from+d)&mask;
+                if(auto word=occupied[level][i/64]>>(i%64))return d+std::countr_zero(word);
+                d+=64-i%64;
+            }
+            return slot_count;
+        }
+
+        void cascade(unsigned level,unsigned index) noexcept{
+            _detail::_slot_link list;
+            move_list(slots[level][index],list);
+            occupied[level][index/64]&=~(std::uint64_t(1)<<(index%64));
+            while(list.linked()){
+                auto &n=static_cast<_detail::_timer_node &>(*list.next);
+                n.erase();
+                place(n);
+            }
+        }
+
+        std::size_t process_tick(){
+            auto index=static_cast<unsigned>(next_tick&mask);
+            if(!index)
+                for(unsigned level=1;level<levels;++level){
+                    auto i=static_cast<unsigned>((next_tick>>(bits*level))&mask);
+                    cascade(level,i);
+                    if(i)break;
+                }
+            _detail::_slot_link due;
+            move_list(slots[0][index],due);
+            occupied[0][index/64]&=~(std::uint64_t(1)<<(index%64));
+            ++next_tick; // timers inserted when firing go to next tick
+            std::size_t fired=0;
+            while(due.linked()){
+                auto &n=static_cast<_detail::_timer_node &>(*due.next);
+                n.erase();
+                --count;
+                ++fired;
+                CHZN_ASYNC_WATCHDOG_NEST;
+                _detail::_coop_refill();
+                n.fire(n);
+            }
+            return fired;
+        }
+    };
+
+    namespace _detail{
+        inline timer_wheel &_require_timer_wheel(){
+            auto w=timer_wheel::current();
+            if(!w)[[unlikely]]CHZN_ASYNC_THROW(std::logic_error("chzn timer used without current chzn::timer_wheel"));
+            return *w;
+        }
+
+        struct _sleep_awaiter:public _timer_node{
+            timer_wheel *wheel;
+            std::coroutine_handle<> handle;
+            bool ready;
+
+            _sleep_awaiter(timer_wheel &w,std::uint64_t expiry,bool ready) noexcept:wheel(&w),ready(ready){
+                this->expiry=expiry;
+            }
+
+            ~_sleep_awaiter(){wheel->cancel(*this);}
+
+            bool await_ready() const noexcept{return ready;}
+
+            void await_suspend(std::coroutine_handle<> h) noexcept{
+                handle=h;
+                fire=[](_timer_node &n){static_cast<_sleep_awaiter &>(n).handle.resume();};
+                wheel->insert(*this);
+            }
+
+            static void await_resume() noexcept{}
+
+            void await_cancel() noexcept{wheel->cancel(*this);}
+        };
+
+        // lives in frame of with_timeout
+        template<typename T>
+        struct _timeout_state:public _timer_node{
+            timer_wheel *wheel;
+            std::optional<_join_value_t<T>> value;
+            std::exception_ptr error;
+            task::promise_type *child=nullptr;
+            std::coroutine_handle<> parent;
+
+            // with_timeout destroyed while waiting
+            ~_timeout_state(){
+                if(linked())wheel->cancel(*this);
+            }
+
+            std::coroutine_handle<> finish() noexcept{
+                if(!parent)return std::noop_coroutine(); // completed before suspend
+                wheel->cancel(*this);
+                return parent;
+            }
+
+            bool await_ready() const noexcept{return value||error;}
+
+            void await_suspend(std::coroutine_handle<> h) noexcept{
+                parent=h;
+                fire=[](_timer_node &n){
+                    auto &s=static_cast<_timeout_state &>(n);
+                    s.child->cancel();
+                    s.parent.resume();
+                };
+                wheel->insert(*this);
+            }
+
+            static void await_resume() noexcept{}
+        };
+
+        // a task resume with_timeout when done
+        template<typename T>
+        struct _timeout_child{
+            struct promise_type:public task::promise_type{
+                _timeout_state<T> &state;
+
+                template<typename A>
+                promise_type(A &,_timeout_state<T> &s):state(s){s.child=this;}
+
+                _timeout_child get_return_object(){return {std::coroutine_handle<promise_type>::from_promise(*this)};}
+
+                void unhandled_exception(){state.error=std::current_exception();}
+
+                struct suspend_final:public std::suspend_always{
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept{
+                        return handle.promise().state.finish();
+                    }
+                };
+
+                suspend_final final_suspend() const noexcept{return {};}
+            };
+
+            std::coroutine_handle<promise_type> coroutine;
+
+            _timeout_child(std::coroutine_handle<promise_type> h):coroutine(h){}
+
+            _timeout_child(_timeout_child &) = delete;
+
+            ~_timeout_child(){coroutine.destroy();}
+        };
+
+        template<typename T,typename A>
+        _timeout_child<T> _timeout_run(A &a,_timeout_state<T> &state){
+            if constexpr(std::is_void_v<T>){
+                co_await std::forward<A>(a);
+                state.value.emplace();
+            }
+            else state.value.emplace(co_await std::forward<A>(a));
+        }
+
+        template<typename T>
+        using _timeout_result_t=std::conditional_t<std::is_void_v<T>,bool,std::optional<T>>;
+
+        template<typename T,typename A>
+        async<_timeout_result_t<T>> _with_timeout(A a,timer_wheel::clock::duration d){
+            _timeout_state<T> state;
+            state.wheel=&_require_timer_wheel();
+            state.expiry=state.wheel->to_tick(timer_wheel::clock::now()+d);
+            _timeout_child<T> child=_timeout_run<T,A>(a,state);
+            co_await state;
+            if(state.error)std::rethrow_exception(state.error);
+            if constexpr(std::is_void_v<T>)co_return state.value.has_value();
+            else co_return std::move(state.value);
+        }
+    }
+
+    template<typename Rep,typename Period>
+    inline _detail::_sleep_awaiter sleep_for(std::chrono::duration<Rep,Period> d){
+        auto &w=_detail::_require_timer_wheel();
+        return {w,w.to_tick(timer_wheel::clock::now()+d),d<=d.zero()};
+    }
+
+    inline _detail::_sleep_awaiter sleep_until(timer_wheel::clock::time_point tp){
+        auto &w=_detail::_require_timer_wheel();
+        return {w,w.to_tick(tp),tp<=timer_wheel::clock::now()};
+    }
+
+    template<typename A,typename Rep,typename Period>
+    auto with_timeout(A &&a,std::chrono::duration<Rep,Period> d){
+        using T=_detail::_co_await_T<A>::type;
+        return _detail::_with_timeout<T,A>(std::forward<A>(a),std::chrono::duration_cast<timer_wheel::clock::duration>(d));
+    }
+}
+
+/*
+ * version 1.7.0 IO
+ * 2026/10/16
+ * linux only
+ * type:
+ * - chzn::io_context
+ *   usage:
+ *   - event loop of one thread, use io_uring (linux 5.11+) by raw syscalls, or epoll if io_uring is not available;
+ *   - operations submitted in one loop iteration go to kernel together in one io_uring_enter;
+ *   - completion resume the coroutine co_awaiting the operation directly;
+ *   - io_context constructed in a thread become current io_context of the thread if there is none,
+ *     run() make it current while running;
+ *   - post from other thread wake the loop through an eventfd;
+ *   - own a chzn::timer_wheel, current while run(), loop wait no longer than next timer;
+ *   - operations must be completed before io_context destruct;
+ *   - not copyable, not movable;
+ *   member function:
+ *   - io_context(unsigned entries=256,bool use_io_uring=true)
+ *   - run()
+ *     run loop until stop() or there is no pending operation, no timer and no posted coroutine;
+ *   - run_once(int timeout_ms=-1)
+ *     submit operations, wait at most timeout_ms (-1 forever) for completions and resume them, fire timers;
+ *   - stop()
+ *     thread safe;
+ *   - post(std::coroutine_handle<> handle)
+ *     resume handle in loop, thread safe;
+ *   - get_executor()
+ *   - uses_io_uring()
+ *   - pending()
+ *     number of operations not completed;
+ *   - timers()
+ *     the timer_wheel;
+ *   static member function:
+ *   - current()
+ *     current io_context of this thread, or nullptr;
+ * function:
+ * - chzn::async_read(int fd,std::span<std::byte> buf,std::int64_t offset=-1)
+ * - chzn::async_write(int fd,std::span<const std::byte> buf,std::int64_t offset=-1)
+ * - chzn::async_accept(int fd)
+ * - chzn::async_connect(int fd,const sockaddr *addr,socklen_t len)
+ * - chzn::async_fsync(int fd)
+ *   return chzn::async<ssize_t>, submitted to current io_context when co_awaited,
+ *   throw std::logic_error if there is no current io_context;
+ *   result is same as the syscall, but -errno on error;
+ *   offset -1 means current file position;
+ *   fd returned by async_accept is non-blocking and close-on-exec;
+ *   with epoll, fd of pipe or socket should be non-blocking, waiting on an fd epoll can not watch
+ *   completes with -errno of epoll_ctl;
+ * */
+#if defined(__linux__)
+#include <span>
+#include <unordered_map>
+#include <algorithm>
+#include <system_error>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define CHZN_ASYNC_HAS_IO_URING 1
+#endif
+namespace chzn{
+    struct io_context;
+
+    namespace _detail{
+        enum class _io_kind:unsigned char{
+            read,
+            write,
+            accept,
+            connect,
+            fsync,
+        };
+
+        // lives in frame of the coroutine co_awaiting the operation
+        struct _io_op{
+            _io_kind kind;
+            int fd;
+            void *buf=nullptr;
+            std::size_t len=0;
+            std::int64_t offset=-1;
+            sockaddr_storage addr{};
+            socklen_t addrlen=0;
+            bool connecting=false;
+            co_returner<ssize_t> *returner=nullptr;
+            _io_op *next=nullptr;
+
+            bool wants_write() const noexcept{
+                return kind==_io_kind::write||kind==_io_kind::connect;
+            }
+
+            // non-blocking try for epoll, -EAGAIN if not ready
+            ssize_t perform() noexcept{
+                ssize_t r=0;
+                switch(kind){
+                    case _io_kind::read:
+                        r=offset<0?::read(fd,buf,len): ::pread(fd,buf,len,offset);
+                        break;
+                    case _io_kind::write:
+                        r=offset<0?::write(fd,buf,len): ::pwrite(fd,buf,len,offset);
+                        break;
+                    case _io_kind::accept:
+                        r=::accept4(fd,nullptr,nullptr,SOCK_CLOEXEC|SOCK_NONBLOCK);
+                        break;
+                    case _io_kind::connect:
+                        if(connecting){ // became writable
+                            int error=0;
+                            socklen_t size=sizeof(error);
+                            if(::getsockopt(fd,SOL_SOCKET,SO_ERROR,&error,&size)<0)return -errno;
+                            return -error;
+                        }
+                        r=::connect(fd,reinterpret_cast<const sockaddr *>(&addr),addrlen);
+                        if(r<0&&errno==EINPROGRESS){
+                            connecting=true;
+                            return -EAGAIN;
+                        }
+                        break;
+                    case _io_kind::fsync:
+                        r=::fsync(fd);
+                        break;
+                }
+                if(r<0)return errno==EWOULDBLOCK?-EAGAIN:-errno;
+                return r;
+            }
+        };
+
+        struct _io_submit{
+            _io_op op;
+            io_context *context;
+
+            void operator()(co_returner<ssize_t> &r) noexcept;
+        };
+
+        inline io_context *_require_io_context();
+    }
+
+    struct io_context{
+        explicit io_context(unsigned entries=256,bool use_io_uring=true){
+            wake_fd=::eventfd(0,EFD_CLOEXEC|EFD_NONBLOCK);
+            if(wake_fd<0)CHZN_ASYNC_THROW(std::system_error(errno,std::system_category(),"eventfd"));
+#ifdef CHZN_ASYNC_HAS_IO_URING
+            if(use_io_uring&&setup_uring(entries))arm_wake();
+            else
+#endif
+                setup_epoll();
+            if(!current())current()=this;
+        }
+
+        io_context(io_context &) = delete;
+
+        void operator=(io_context &) = delete;
+
+        ~io_context(){
+            if(current()==this)current()=nullptr;
+#ifdef CHZN_ASYNC_HAS_IO_URING
+            if(ring_fd>=0){
+                ::munmap(sqes,sqes_size);
+                ::munmap(ring,ring_size);
+                ::close(ring_fd);
+            }
+#endif
+            if(epoll_fd>=0)::close(epoll_fd);
+            ::close(wake_fd);
+        }
+
+        static io_context *&current() noexcept{
+            thread_local io_context *c=nullptr;
+            return c;
+        }
+
+        bool uses_io_uring() const noexcept{
+#ifdef CHZN_ASYNC_HAS_IO_URING
+            return ring_fd>=0;
+#else
+            return false;
+#endif
+        }
+
+        std::size_t pending() const noexcept{return operations;}
+
+        timer_wheel &timers() noexcept{return wheel;}
+
+        void stop() noexcept{
+            stopped.store(true,std::memory_order_relaxed);
+            wake();
+        }
+
+        void run(){
+            auto previous=std::exchange(current(),this);
+            auto previous_wheel=std::exchange(timer_wheel::current(),&wheel);
+            auto previous_executor=set_current_executor(get_executor());
+            owner.store(std::this_thread::get_id(),std::memory_order_relaxed);
+            stopped.store(false,std::memory_order_relaxed);
+            while(!stopped.load(std::memory_order_relaxed)
+                  &&(operations||!wheel.empty()||!ready.empty()||remote_nonempty.load(std::memory_order_acquire)))
+                run_once(-1);
+            owner.store({},std::memory_order_relaxed);
+            set_current_executor(previous_executor);
+            timer_wheel::current()=previous_wheel;
+            current()=previous;
+        }
+
+        void run_once(int timeout_ms=-1){
+            if(!ready.empty()||remote_nonempty.load(std::memory_order_acquire))timeout_ms=0;
+            else if(auto next=wheel.next_expiry()){
+                auto now=timer_wheel::clock::now();
+                auto wait=*next>now?std::chrono::ceil<std::chrono::milliseconds>(*next-now).count():0;
+                if(timeout_ms<0||wait<timeout_ms)timeout_ms=static_cast<int>(wait);
+            }
+#ifdef CHZN_ASYNC_HAS_IO_URING
+            if(ring_fd>=0)wait_uring(timeout_ms);
+            else
+#endif
+                wait_epoll(timeout_ms);
+            if(!wheel.empty())wheel.advance();
+            take_remote();
+            // coroutines posted while resuming wait for next iteration
+            for(auto count=ready.size();count;--count){
+                auto h=ready.front();
+                ready.pop_front();
+                CHZN_ASYNC_WATCHDOG_NEST;
+                _detail::_coop_refill();
+                h.resume();
+            }
+        }
+
+        void post(std::coroutine_handle<> handle){
+            if(owner.load(std::memory_order_relaxed)==std::this_thread::get_id()){
+                ready.push_back(handle);
+                return;
+            }
+            {
+                std::lock_guard lock(remote_mutex);
+                remote.push_back(handle);
+                remote_nonempty.store(true,std::memory_order_release);
+            }
+            wake();
+        }
+
+        executor get_executor() noexcept{
+            return {this,[](void *context,std::coroutine_handle<> handle){static_cast<io_context *>(context)->post(handle);}};
+        }
+
+    private:
+        friend _detail::_io_submit;
+
+        int wake_fd=-1;
+        std::uint64_t wake_value=0;
+        std::atomic<bool> stopped=false;
+        std::atomic<std::thread::id> owner;
+        std::size_t operations=0;
+        std::deque<std::coroutine_handle<>> ready;
+        std::mutex remote_mutex;
+        std::vector<std::coroutine_handle<>> remote;
+        std::atomic<bool> remote_nonempty=false;
+        timer_wheel wheel;
+
+        void wake() noexcept{
+            std::uint64_t one=1;
+            [[maybe_unused]] auto r=::write(wake_fd,&one,sizeof(one));
+        }
+
+        void take_remote(){
+            if(!remote_nonempty.load(std::memory_order_acquire))return;
+            std::vector<std::coroutine_handle<>> handles;
+            {
+                std::lock_guard lock(remote_mutex);
+                std::swap(handles,remote);
+                remote_nonempty.store(false,std::memory_order_relaxed);
+            }
+            ready.insert(ready.end(),handles.begin(),handles.end());
+        }
+
+        void submit(_detail::_io_op &op){
+            ++operations;
+#ifdef CHZN_ASYNC_HAS_IO_URING
+            if(ring_fd>=0)return submit_uring(op);
+#endif
+            submit_epoll(op);
+        }
+
+        void complete(_detail::_io_op &op,ssize_t result){
+            --operations;
+            op.returner->return_value(result);
+        }
+
+        // epoll: ops of one fd wait in FIFO lists, one list per direction
+        struct fd_waiters{
+            _detail::_io_op *readers=nullptr,*readers_tail=nullptr;
+            _detail::_io_op *writers=nullptr,*writers_tail=nullptr;
+            std::uint32_t events=0;
+        };
+
+        int epoll_fd=-1;
+        std::unordered_map<int,fd_waiters> waiting;
+        // completed when submitted, resumed in loop, not in await_suspend
+        std::vector<std::pair<_detail::_io_op *,ssize_t>> finished;
+
+        void setup_epoll(){
+            epoll_fd=::epoll_create1(EPOLL_CLOEXEC);
+            if(epoll_fd<0)CHZN_ASYNC_THROW(std::system_error(errno,std::system_category(),"epoll_create1"));
+            epoll_event e{};
+            e.events=EPOLLIN;
+            e.data.fd=wake_fd;
+            if(::epoll_ctl(epoll_fd,EPOLL_CTL_ADD,wake_fd,&e)<0)
+                CHZN_ASYNC_THROW(std::system_error(errno,std::system_category(),"epoll_ctl"));
+        }
+
+        static void push(_detail::_io_op *&head,_detail::_io_op *&tail,_detail::_io_op &op) noexcept{
+            op.next=nullptr;
+            if(tail)tail->next=&op;
+            else head=&op;
+            tail=&op;
+        }
+
+        void drain(_detail::_io_op *&head,_detail::_io_op *&tail){
+            while(head){
+                auto result=head->perform();
+                if(result==-EAGAIN)break;
+                finished.emplace_back(head,result);
+                head=head->next;
+                if(!head)tail=nullptr;
+            }
+        }
+
+        void update_interest(int fd,fd_waiters &w){
+            std::uint32_t events=(w.readers?EPOLLIN:0u)|(w.writers?EPOLLOUT:0u);
+            if(events==w.events){
+                if(!events)waiting.erase(fd);
+                return;
+            }
+            epoll_event e{};
+            e.events=events;
+            e.data.fd=fd;
+            if(::epoll_ctl(epoll_fd,!events?EPOLL_CTL_DEL:w.events?EPOLL_CTL_MOD:EPOLL_CTL_ADD,fd,&e)<0&&events)[[unlikely]]
+                return fail(fd,w,-errno);
+            if(!events)waiting.erase(fd);
+            else w.events=events;
+        }
+
+        // fd can not be watched (EPERM for a regular file), complete its waiters with the error
+        void fail(int fd,fd_waiters &w,ssize_t error){
+            for(auto op=w.readers;op;op=op->next)finished.emplace_back(op,error);
+            for(auto op=w.writers;op;op=op->next)finished.emplace_back(op,error);
+            if(w.events)::epoll_ctl(epoll_fd,EPOLL_CTL_DEL,fd,nullptr);
+            waiting.erase(fd);
+        }
+
+        void submit_epoll(_detail::_io_op &op){
+            auto &w=waiting[op.fd];
+            auto [head,tail]=op.wants_write()?std::tie(w.writers,w.writers_tail):std::tie(w.readers,w.readers_tail);
+            if(!head){ // try now, keep order of queued ops
+                auto result=op.perform();
+                if(result!=-EAGAIN){
+                    finished.emplace_back(&op,result);
+                    return update_interest(op.fd,w);
+                }
+            }
+            push(head,tail,op);
+            update_interest(op.fd,w);
+        }
+
+        void wait_epoll(int timeout_ms){
+            if(!finished.empty())timeout_ms=0;
+            epoll_event events[64];
+            int n=::epoll_wait(epoll_fd,events,64,timeout_ms);
+            for(int i=0;i<n;++i){
+                int fd=events[i].data.fd;
+                if(fd==wake_fd){
+                    [[maybe_unused]] auto r=::read(wake_fd,&wake_value,sizeof(wake_value));
+                    continue;
+                }
+                auto it=waiting.find(fd);
+                if(it==waiting.end())continue;
+                auto &w=it->second;
+                auto flags=events[i].events;
+                if(flags&(EPOLLIN|EPOLLERR|EPOLLHUP))drain(w.readers,w.readers_tail);
+                if(flags&(EPOLLOUT|EPOLLERR|EPOLLHUP))drain(w.writers,w.writers_tail);
+                update_interest(fd,w);
+            }
+            while(!finished.empty()){
+                auto ops=std::move(finished);
+                finished.clear();
+                for(auto [op,result]:ops)complete(*op,result);
+            }
+        }
+
+#ifdef CHZN_ASYNC_HAS_IO_URING
+        // io_uring without liburing, single mmap of sq and cq ring
+        int ring_fd=-1;
+        void *ring=nullptr;
+        std::size_t ring_size=0,sqes_size=0;
+        io_uring_sqe *sqes=nullptr;
+        io_uring_cqe *cqes=nullptr;
+        unsigned *sq_head=nullptr,*sq_tail=nullptr,*sq_array=nullptr,sq_mask=0,sq_entries=0;
+        unsigned *cq_head=nullptr,*cq_tail=nullptr,cq_mask=0;
+        unsigned to_submit=0;
+        static constexpr std::uint64_t wake_tag=0; // user_data of eventfd read, op is never nullptr
+
+        static unsigned load_acquire(unsigned *p) noexcept{
+            return std::atomic_ref(*p).load(std::memory_order_acquire);
+        }
+
+        static void store_release(unsigned *p,unsigned v) noexcept{
+            std::atomic_ref(*p).store(v,std::memory_order_release);
+        }
+
+        int enter(unsigned submit,unsigned min_complete,unsigned flags,void *arg=nullptr,std::size_t arg_size=0) noexcept{
+            return static_cast<int>(::syscall(__NR_io_uring_enter,ring_fd,submit,min_complete,flags,arg,arg_size));
+        }
+
+        bool setup_uring(unsigned entries){
+            io_uring_params p{};
+            ring_fd=static_cast<int>(::syscall(__NR_io_uring_setup,entries,&p));
+            if(ring_fd<0)return false;
+            if(!(p.features&IORING_FEAT_SINGLE_MMAP)||!(p.features&IORING_FEAT_EXT_ARG)){
+                ::close(ring_fd);
+                ring_fd=-1;
+                return false;
+            }
+            ring_size=std::max<std::size_t>(p.sq_off.array+p.sq_entries*sizeof(unsigned),
+                                            p.cq_off.cqes+p.cq_entries*sizeof(io_uring_cqe));
+            ring=::mmap(nullptr,ring_size,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,ring_fd,IORING_OFF_SQ_RING);
+            if(ring==MAP_FAILED){
+                ::close(ring_fd);
+                ring_fd=-1;
+                return false;
+            }
+            sqes_size=p.sq_entries*sizeof(io_uring_sqe);
+            auto s=::mmap(nullptr,sqes_size,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,ring_fd,IORING_OFF_SQES);
+            if(s==MAP_FAILED){
+                ::munmap(ring,ring_size);
+                ::close(ring_fd);
+                ring_fd=-1;
+                return false;
+            }
+            sqes=static_cast<io_uring_sqe *>(s);
+            auto r=static_cast<std::byte *>(ring);
+            sq_head=reinterpret_cast<unsigned *>(r+p.sq_off.head);
+            sq_tail=reinterpret_cast<unsigned *>(r+p.sq_off.tail);
+            sq_array=reinterpret_cast<unsigned *>(r+p.sq_off.array);
+            sq_mask=*reinterpret_cast<unsigned *>(r+p.sq_off.ring_mask);
+            sq_entries=p.sq_entries;
+            cq_head=reinterpret_cast<unsigned *>(r+p.cq_off.head);
+            cq_tail=reinterpret_cast<unsigned *>(r+p.cq_off.tail);
+            cq_mask=*reinterpret_cast<unsigned *>(r+p.cq_off.ring_mask);
+            cqes=reinterpret_cast<io_uring_cqe *>(r+p.cq_off.cqes);
+            return true;
+        }
+
+        io_uring_sqe &get_sqe() noexcept{
+            auto tail=*sq_tail;
+            if(tail-load_acquire(sq_head)==sq_entries)[[unlikely]]{ // full, submit batch now
+                enter(to_submit,0,0);
+                to_submit=0;
+            }
+            auto index=tail&sq_mask;
+            sq_array[index]=index;
+            auto &sqe=sqes[index];
+            std::memset(&sqe,0,sizeof(sqe));
+            return sqe;
+        }
+
+        void push_sqe() noexcept{
+            store_release(sq_tail,*sq_tail+1);
+            ++to_submit;
+        }
+
+        void arm_wake() noexcept{
+            auto &sqe=get_sqe();
+            sqe.opcode=IORING_OP_READ;
+            sqe.fd=wake_fd;
+            sqe.addr=reinterpret_cast<std::uint64_t>(&wake_value);
+            sqe.len=sizeof(wake_value);
+            sqe.user_data=wake_tag;
+            push_sqe();
+        }
+
+        void submit_uring(_detail::_io_op &op) noexcept{
+            auto &sqe=get_sqe();
+            sqe.fd=op.fd;
+            sqe.user_data=reinterpret_cast<std::uint64_t>(&op);
+            switch(op.kind){
+                case _detail::_io_kind::read:
+                case _detail::_io_kind::write:
+                    sqe.opcode=op.kind==_detail::_io_kind::read?IORING_OP_READ:IORING_OP_WRITE;
+                    sqe.addr=reinterpret_cast<std::uint64_t>(op.buf);
+                    sqe.len=static_cast<unsigned>(op.len);
+                    sqe.off=static_cast<std::uint64_t>(op.offset); // -1 is current position
+                    break;
+                case _detail::_io_kind::accept:
+                    sqe.opcode=IORING_OP_ACCEPT;
+                    sqe.accept_flags=SOCK_CLOEXEC|SOCK_NONBLOCK;
+                    break;
+                case _detail::_io_kind::connect:
+                    sqe.opcode=IORING_OP_CONNECT;
+                    sqe.addr=reinterpret_cast<std::uint64_t>(&op.addr);
+                    sqe.off=op.addrlen;
+                    break;
+                case _detail::_io_kind::fsync:
+                    sqe.opcode=IORING_OP_FSYNC;
+                    break;
+            }
+            push_sqe();
+        }
+
+        void wait_uring(int timeout_ms){
+            __kernel_timespec ts{};
+            io_uring_getevents_arg arg{};
+            if(timeout_ms>=0){
+                ts.tv_sec=timeout_ms/1000;
+                ts.tv_nsec=timeout_ms%1000*1000000ll;
+                arg.ts=reinterpret_cast<std::uint64_t>(&ts);
+            }
+            unsigned wait=timeout_ms!=0&&load_acquire(cq_tail)==*cq_head;
+            // -ETIME and -EINTR are fine, completions are read below anyway
+            enter(to_submit,wait,IORING_ENTER_GETEVENTS|IORING_ENTER_EXT_ARG,&arg,sizeof(arg));
+            to_submit=0;
+            // only reap what is there now, completions may submit new ops
+            for(auto head=*cq_head,tail=load_acquire(cq_tail);head!=tail;++head){
+                auto cqe=cqes[head&cq_mask];
+                store_release(cq_head,head+1);
+                if(cqe.user_data==wake_tag)arm_wake();
+                else complete(*reinterpret_cast<_detail::_io_op *>(cqe.user_data),cqe.res);
+            }
+        }
+#endif
+    };
+
+    inline io_context *_detail::_require_io_context(){
+        auto context=io_context::current();
+        if(!context)[[unlikely]]CHZN_ASYNC_THROW(std::logic_error("chzn io operation without current chzn::io_context"));
+        return context;
+    }
+
+    inline void _detail::_io_submit::operator()(co_returner<ssize_t> &r) noexcept{
+        op.returner=&r;
+        context->submit(op);
+    }
+
+    inline async<ssize_t> async_read(int fd,std::span<std::byte> buf,std::int64_t offset=-1){
+        auto context=_detail::_require_io_context();
+        co_return co_await do_async<ssize_t>(_detail::_io_submit{{.kind=_detail::_io_kind::read,.fd=fd,.buf=buf.data(),.len=buf.size(),.offset=offset},context});
+    }
+
+    inline async<ssize_t> async_write(int fd,std::span<const std::byte> buf,std::int64_t offset=-1){
+        auto context=_detail::_require_io_context();
+        co_return co_await do_async<ssize_t>(_detail::_io_submit{{.kind=_detail::_io_kind::write,.fd=fd,.buf=const_cast<std::byte *>(buf.data()),.len=buf.size(),.offset=offset},context});
+    }
+
+    inline async<ssize_t> async_accept(int fd){
+        auto context=_detail::_require_io_context();
+        co_return co_await do_async<ssize_t>(_detail::_io_submit{{.kind=_detail::_io_kind::accept,.fd=fd},context});
+    }
+
+    inline async<ssize_t> async_connect(int fd,const sockaddr *addr,socklen_t len){
+        auto context=_detail::_require_io_context();
+        if(len>sizeof(sockaddr_storage))co_return -EINVAL;
+        _detail::_io_submit submit{{.kind=_detail::_io_kind::connect,.fd=fd,.addrlen=len},context};
+        std::memcpy(&submit.op.addr,addr,len);
+        co_return co_await do_async<ssize_t>(std::move(submit));
+    }
+
+    inline async<ssize_t> async_fsync(int fd){
+        auto context=_detail::_require_io_context();
+        co_return co_await do_async<ssize_t>(_detail::_io_submit{{.kind=_detail::_io_kind::fsync,.fd=fd},context});
+    }
+}
+#endif
+
+/*
+ * version 1.8.0 Generator
+ * 2026/10/16
+ * type:
+ * - chzn::async_generator<T>
+ *   usage:
+ *   - a function return chzn::async_generator<T> is a coroutine, it can co_yield T many times and co_await anything;
+ *   - lazy start, producer runs only when consumer co_await next(), and suspends at each co_yield until next pull;
+ *   - a yielded rvalue is handed over by pointer, not copied, valid until next co_await next();
+ *     consumer can move from it;
+ *   - co_yield an lvalue copies it into the frame of producer, co_yield std::move(v) to hand v over;
+ *   - move only, destruct it to stop the producer;
+ *   member function:
+ *   - next()
+ *     co_await it to get T*, nullptr when the producer returns, rethrow if the producer throws;
+ *   - while(auto row=co_await gen.next())use(*row);
+ * */
+namespace chzn{
+    template<typename T>
+    struct async_generator{
+        struct promise_type:public _detail::_frame_memory{
+            async_generator get_return_object(){return {handle_type::from_promise(*this)};}
+
+            constexpr std::suspend_always initial_suspend() const noexcept{return {};}
+
+            // give control back to consumer
+            struct suspend_yield:public std::suspend_always{
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept{
+                    return handle.promise().consumer;
+                }
+            };
+
+            // value of co_yield expression lives until producer resumes
+            suspend_yield yield_value(T &&t) noexcept{
+                value=std::addressof(t);
+                return {};
+            }
+
+            struct suspend_yield_copy:public suspend_yield{
+                T copy;
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept{
+                    handle.promise().value=std::addressof(copy);
+                    return suspend_yield::await_suspend(handle);
+                }
+            };
+
+            suspend_yield_copy yield_value(const T &t){return {{},t};}
+
+            constexpr void return_void() const noexcept{}
+
+            void unhandled_exception(){error=std::current_exception();}
+
+            constexpr suspend_yield final_suspend() const noexcept{return {};}
+
+            T *value=nullptr;
+            std::exception_ptr error;
+            std::coroutine_handle<> consumer=std::noop_coroutine();
+        };
+
+        using handle_type=std::coroutine_handle<promise_type>;
+        handle_type coroutine;
+
+        struct next_awaiter{
+            handle_type coroutine;
+
+            bool await_ready() const noexcept{return coroutine.done();}
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle) const noexcept{
+                coroutine.promise().consumer=handle;
+                coroutine.promise().value=nullptr;
+                return coroutine;
+            }
+
+            T *await_resume() const{
+                auto &p=coroutine.promise();
+                if(p.error)[[unlikely]]std::rethrow_exception(std::exchange(p.error,nullptr));
+                if(coroutine.done())return nullptr;
+                return p.value;
+            }
+        };
+
+        next_awaiter next() const noexcept{return {coroutine};}
+
+        ~async_generator(){
+            if(coroutine)coroutine.destroy();
+        }
+
+        async_generator() = default;
+
+        async_generator(handle_type handle):coroutine(handle){}
+
+        async_generator(async_generator &) = delete;
+
+        async_generator(async_generator &&g) noexcept{std::swap(coroutine,g.coroutine);}
+
+        async_generator &operator=(async_generator &) = delete;
+
+        async_generator &operator=(async_generator &&g) noexcept{
+            std::swap(coroutine,g.coroutine);
+            return *this;
+        }
+    };
+}
+
+/*
+ * version 1.9.0 Channel
+ * 2026/10/16
+ * type:
+ * - chzn::channel<T>
+ *   usage:
+ *   - bounded multi producer multi consumer queue between coroutines of any thread;
+ *   - every value goes to exactly one receiver, in FIFO order;
+ *   - values live in a lock free ring (capacity rounded up to power of 2, at least 2),
+ *     send and recv do not lock unless somebody is waiting;
+ *   - a full channel parks senders, an empty channel parks receivers, parked coroutines wait in intrusive lists
+ *     in their frames, and get value or space directly from whoever unparks them;
+ *   - parked coroutine is resumed by the executor current when it co_await, resume inline if there is none;
+ *   - send_many/recv_many claim as many ring slots as are free or filled in one step,
+ *     values claimed in one step are adjacent in the channel;
+ *   - after close(), send fails, recv gets values still in channel, then nullopt;
+ *   - destruct close it;
+ *   - not copyable, not movable;
+ *   member function:
+ *   - channel(std::size_t capacity)
+ *   - send(T t)
+ *     co_await it to get bool, false if channel is closed;
+ *   - recv()
+ *     co_await it to get std::optional<T>, nullopt if channel is closed and empty;
+ *   - recv_many(std::span<T> out)
+ *     co_await it to wait for at least one value and get how many values are moved to out, 0 if closed and empty;
+ *   - send_many(std::span<T> in)
+ *     co_await it to move values of in to channel in order, waiting for space,
+ *     and get how many are sent, less than in.size() only if channel is closed;
+ *   - try_send(T &&t)/try_send(const T &t)
+ *     return false if channel is full or closed, t is not moved then;
+ *   - try_send_many(std::span<T> in)
+ *     move values from the front of in while there is space, return how many, 0 if closed;
+ *   - try_recv()
+ *     return std::optional<T>, nullopt if channel is empty;
+ *   - close()
+ *   - is_closed()
+ *   - capacity()
+ * */
+#include <span>
+namespace chzn{
+    namespace _detail{
+        struct _channel_waiter:public _slot_link{
+            std::coroutine_handle<> coroutine;
+            executor home;
+        };
+
+        // bounded MPMC ring of Dmitry Vyukov
+        template<typename T>
+        struct _channel_ring{
+            struct cell{
+                std::atomic<std::size_t> sequence;
+                alignas(T) std::byte value[sizeof(T)];
+            };
+
+            std::size_t mask;
+            std::unique_ptr<cell[]> cells;
+            alignas(64) std::atomic<std::size_t> enqueue_pos=0;
+            alignas(64) std::atomic<std::size_t> dequeue_pos=0;
+
+            explicit _channel_ring(std::size_t capacity){
+                std::size_t c=2;
+                while(c<capacity)c<<=1;
+                mask=c-1;
+                cells.reset(new cell[c]);
+                for(std::size_t i=0;i<c;++i)cells[i].sequence.store(i,std::memory_order_relaxed);
+            }
+
+            ~_channel_ring(){
+                std::optional<T> v;
+                while(pop(v));
+            }
+
+            // t is not moved if full
+            template<typename U>
+            bool push(U &&t){
+                auto pos=enqueue_pos.load(std::memory_order_relaxed);
+                cell *c;
+                for(;;){
+                    c=&cells[pos&mask];
+                    auto seq=c->sequence.load(std::memory_order_acquire);
+                    auto dif=static_cast<std::intptr_t>(seq-pos);
+                    if(dif==0){
+                        if(enqueue_pos.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed))break;
+                    }else if(dif<0)return false;
+                    else pos=enqueue_pos.load(std::memory_order_relaxed);
+                }
+                new(&c->value) T(std::forward<U>(t));
+                c->sequence.store(pos+1,std::memory_order_release);
+                return true;
+            }
+
+            // move a prefix of in, as long as fits, with one claim, return its length
+            std::size_t push_many(std::span<T> in){
+                if(in.empty())return 0;
+                auto pos=enqueue_pos.load(std::memory_order_relaxed);
+                for(;;){
+                    auto dif=static_cast<std::intptr_t>(cells[pos&mask].sequence.load(std::memory_order_acquire)-pos);
+                    if(dif<0)return 0;
+                    if(dif>0){
+                        pos=enqueue_pos.load(std::memory_order_relaxed);
+                        continue;
+                    }
+                    std::size_t n=1;
+                    while(n<in.size()&&cells[(pos+n)&mask].sequence.load(std::memory_order_acquire)==pos+n)++n;
+                    if(!enqueue_pos.compare_exchange_weak(pos,pos+n,std::memory_order_relaxed))continue;
+                    for(std::size_t i=0;i<n;++i){
+                        auto &c=cells[(pos+i)&mask];
+                        new(&c.value) T(std::move(in[i]));
+                        c.sequence.store(pos+i+1,std::memory_order_release);
+                    }
+                    return n;
+                }
+            }
+
+            // fill a prefix of out, as long as is filled, with one claim, return its length
+            std::size_t pop_many(std::span<T> out){
+                if(out.empty())return 0;
+                auto pos=dequeue_pos.load(std::memory_order_relaxed);
+                for(;;){
+                    auto dif=static_cast<std::intptr_t>(cells[pos&mask].sequence.load(std::memory_order_acquire)-(pos+1));
+                    if(dif<0)return 0;
+                    if(dif>0){
+                        pos=dequeue_pos.load(std::memory_order_relaxed);
+                        continue;
+                    }
+                    std::size_t n=1;
+                    while(n<out.size()&&cells[(pos+n)&mask].sequence.load(std::memory_order_acquire)==pos+n+1)++n;
+                    if(!dequeue_pos.compare_exchange_weak(pos,pos+n,std::memory_order_relaxed))continue;
+                    for(std::size_t i=0;i<n;++i){
+                        auto &c=cells[(pos+i)&mask];
+                        auto &v=reinterpret_cast<T &>(c.value);
+                        out[i]=std::move(v);
+                        v.~T();
+                        c.sequence.store(pos+i+mask+1,std::memory_order_release);
+                    }
+                    return n;
+                }
+            }
+
+            bool pop(std::optional<T> &out){
+                auto pos=dequeue_pos.load(std::memory_order_relaxed);
+                cell *c;
+                for(;;){
+                    c=&cells[pos&mask];
+                    auto seq=c->sequence.load(std::memory_order_acquire);
+                    auto dif=static_cast<std::intptr_t>(seq-(pos+1));
+                    if(dif==0){
+                        if(dequeue_pos.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed))break;
+                    }else if(dif<0)return false;
+                    else pos=dequeue_pos.load(std::memory_order_relaxed);
+                }
+                auto &v=reinterpret_cast<T &>(c->value);
+                out.emplace(std::move(v));
+                v.~T();
+                c->sequence.store(pos+mask+1,std::memory_order_release);
+                return true;
+            }
+        };
+    }
+
+    template<typename T>
+    struct channel{
+        struct recv_awaiter:public _detail::_channel_waiter{
+            channel &ch;
+            std::optional<T> value;
+
+            recv_awaiter(channel &ch) noexcept:ch(ch){}
+
+            recv_awaiter(recv_awaiter &&r) noexcept:_detail::_channel_waiter(r),ch(r.ch),value(std::move(r.value)){}
+
+            ~recv_awaiter(){if(this->linked())ch.unpark(*this,ch.waiting_receivers);}
+
+            bool await_ready(){
+                if(ch.ring.pop(value)){
+                    ch.after_pop();
+                    return true;
+                }
+                if(!ch.closed.load(std::memory_order_acquire))return false;
+                if(ch.ring.pop(value))ch.after_pop(); // pushed before close, empty value if drained
+                return true;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle){
+                this->coroutine=handle;
+                this->home=current_executor();
+                return ch.park_receiver(*this);
+            }
+
+            std::optional<T> await_resume() noexcept{return std::move(value);}
+
+            void await_cancel(){ch.unpark(*this,ch.waiting_receivers);}
+        };
+
+        struct recv_many_awaiter:public recv_awaiter{
+            std::span<T> out;
+
+            recv_many_awaiter(channel &ch,std::span<T> out) noexcept:recv_awaiter(ch),out(out){}
+
+            bool await_ready(){return out.empty()||recv_awaiter::await_ready();}
+
+            std::size_t await_resume(){
+                if(!this->value)return 0;
+                out[0]=std::move(*this->value);
+                auto n=this->ch.ring.pop_many(out.subspan(1));
+                if(n)this->ch.after_pop();
+                return n+1;
+            }
+        };
+
+    private:
+        // parked sender, offer moves what fits into the ring, adds it to pushed, and returns true when all is in
+        struct sender:public _detail::_channel_waiter{
+            bool (*offer)(sender &,std::size_t &pushed);
+        };
+
+    public:
+        struct send_awaiter:public sender{
+            channel &ch;
+            T value;
+            bool sent=false;
+
+            send_awaiter(channel &ch,T &&t):sender{{},&send_awaiter::offer_value},ch(ch),value(std::move(t)){}
+
+            send_awaiter(send_awaiter &&s):sender(s),ch(s.ch),value(std::move(s.value)),sent(s.sent){}
+
+            ~send_awaiter(){if(this->linked())ch.unpark(*this,ch.waiting_senders);}
+
+            static bool offer_value(sender &s,std::size_t &pushed){
+                auto &w=static_cast<send_awaiter &>(s);
+                if(!w.ch.ring.push(std::move(w.value)))return false;
+                w.sent=true;
+                ++pushed;
+                return true;
+            }
+
+            bool await_ready(){
+                if(ch.closed.load(std::memory_order_acquire))return true;
+                if(ch.ring.push(std::move(value))){
+                    sent=true;
+                    ch.after_push();
+                    return true;
+                }
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle){
+                this->coroutine=handle;
+                this->home=current_executor();
+                return ch.park_sender(*this);
+            }
+
+            bool await_resume() const noexcept{return sent;}
+
+            void await_cancel(){ch.unpark(*this,ch.waiting_senders);}
+        };
+
+        struct send_many_awaiter:public sender{
+            channel &ch;
+            std::span<T> in,left;
+
+            send_many_awaiter(channel &ch,std::span<T> in) noexcept:sender{{},&send_many_awaiter::offer_values},ch(ch),in(in),left(in){}
+
+            send_many_awaiter(send_many_awaiter &&s) noexcept:sender(s),ch(s.ch),in(s.in),left(s.left){}
+
+            ~send_many_awaiter(){if(this->linked())ch.unpark(*this,ch.waiting_senders);}
+
+            static bool offer_values(sender &s,std::size_t &pushed){
+                auto &w=static_cast<send_many_awaiter &>(s);
+                auto n=w.ch.ring.push_many(w.left);
+                w.left=w.left.subspan(n);
+                pushed+=n;
+                return w.left.empty();
+            }
+
+            bool await_ready(){
+                if(ch.closed.load(std::memory_order_acquire))return true;
+                auto n=ch.ring.push_many(left);
+                left=left.subspan(n);
+                if(n)ch.after_push();
+                return left.empty();
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle){
+                this->coroutine=handle;
+                this->home=current_executor();
+                return ch.park_sender(*this);
+            }
+
+            std::size_t await_resume() const noexcept{return in.size()-left.size();}
+
+            void await_cancel(){ch.unpark(*this,ch.waiting_senders);}
+        };
+
+        explicit channel(std::size_t capacity):ring(capacity){}
+
+        channel(channel &) = delete;
+
+        void operator=(channel &) = delete;
+
+        ~channel(){close();}
+
+        send_awaiter send(T t){return {*this,std::move(t)};}
+
+        recv_awaiter recv() noexcept{return {*this};}
+
+        recv_many_awaiter recv_many(std::span<T> out) noexcept{return {*this,out};}
+
+        send_many_awaiter send_many(std::span<T> in) noexcept{return {*this,in};}
+
+        bool try_send(T &&t){
+            if(closed.load(std::memory_order_acquire)||!ring.push(std::move(t)))return false;
+            after_push();
+            return true;
+        }
+
+        bool try_send(const T &t){
+            if(closed.load(std::memory_order_acquire)||!ring.push(t))return false;
+            after_push();
+            return true;
+        }
+
+        std::size_t try_send_many(std::span<T> in){
+            if(closed.load(std::memory_order_acquire))return 0;
+            auto n=ring.push_many(in);
+            if(n)after_push();
+            return n;
+        }
+
+        std::optional<T> try_recv(){
+            std::optional<T> v;
+            if(ring.pop(v))after_pop();
+            return v;
+        }
+
+        void close(){
+            closed.store(true,std::memory_order_seq_cst);
+            service();
+        }
+
+        bool is_closed() const noexcept{return closed.load(std::memory_order_acquire);}
+
+        std::size_t capacity() const noexcept{return ring.mask+1;}
+
+    private:
+        _detail::_channel_ring<T> ring;
+        alignas(64) std::atomic<bool> closed=false;
+        std::atomic<std::size_t> waiting_receivers=0,waiting_senders=0; // changed under mutex, read to skip locking
+        std::mutex mutex;
+        _detail::_slot_link receivers,senders; // parked waiters, FIFO
+
+        static void push(_detail::_slot_link &list,_detail::_slot_link &n) noexcept{
+            n.last=list.last;
+            n.next=&list;
+            list.last->next=&n;
+            list.last=&n;
+        }
+
+        // pairs with the fence after parking: either the parker sees the value, or this sees the parker
+        void after_push(){
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(waiting_receivers.load(std::memory_order_relaxed))service();
+        }
+
+        void after_pop(){
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(waiting_senders.load(std::memory_order_relaxed))service();
+        }
+
+        bool park_receiver(recv_awaiter &w){
+            {
+                std::lock_guard lock(mutex);
+                push(receivers,w);
+                waiting_receivers.fetch_add(1,std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if(!ring.pop(w.value)){
+                    if(!closed.load(std::memory_order_relaxed))return true;
+                }
+                w.erase();
+                waiting_receivers.fetch_sub(1,std::memory_order_relaxed);
+            }
+            if(w.value)after_pop();
+            return false;
+        }
+
+        // park only if nothing fits, a batch partly pushed is retried after receivers are told
+        bool park_sender(sender &w){
+            for(bool all=false;!all;){
+                std::size_t pushed=0;
+                {
+                    std::lock_guard lock(mutex);
+                    push(senders,w);
+                    waiting_senders.fetch_add(1,std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    all=closed.load(std::memory_order_relaxed)||w.offer(w,pushed);
+                    if(!all&&!pushed)return true;
+                    w.erase();
+                    waiting_senders.fetch_sub(1,std::memory_order_relaxed);
+                }
+                if(pushed)after_push();
+            }
+            return false;
+        }
+
+        // parked coroutine destroyed
+        void unpark(_detail::_channel_waiter &w,std::atomic<std::size_t> &count){
+            std::lock_guard lock(mutex);
+            if(!w.linked())return;
+            w.erase();
+            count.fetch_sub(1,std::memory_order_relaxed);
+        }
+
+        // hand values and space to parked waiters, resume them after unlock
+        void service(){
+            _detail::_slot_link done;
+            {
+                std::lock_guard lock(mutex);
+                for(bool progress=true;progress;){
+                    progress=false;
+                    while(receivers.linked()){
+                        auto &w=static_cast<recv_awaiter &>(*receivers.next);
+                        if(!ring.pop(w.value))break;
+                        w.erase();
+                        push(done,w);
+                        waiting_receivers.fetch_sub(1,std::memory_order_relaxed);
+                        progress=true;
+                    }
+                    while(senders.linked()&&!closed.load(std::memory_order_relaxed)){
+                        auto &w=static_cast<sender &>(*senders.next);
+                        std::size_t pushed=0;
+                        auto all=w.offer(w,pushed);
+                        if(pushed)progress=true;
+                        if(!all)break;
+                        w.erase();
+                        push(done,w);
+                        waiting_senders.fetch_sub(1,std::memory_order_relaxed);
+                        progress=true;
+                    }
+                }
+                if(closed.load(std::memory_order_relaxed)){
+                    for(auto list:{&receivers,&senders})
+                        while(list->linked()){
+                            auto &w=*list->next;
+                            w.erase();
+                            push(done,w);
+                        }
+                    waiting_receivers.store(0,std::memory_order_relaxed);
+                    waiting_senders.store(0,std::memory_order_relaxed);
+                }
+            }
+            while(done.linked()){
+                auto &w=static_cast<_detail::_channel_waiter &>(*done.next);
+                w.erase();
+                w.home.post(w.coroutine); // w may be gone now
+            }
+        }
+    };
+}
+
+
+/*
+ * version 1.14.0 Shared Async
+ * 2026/10/16
+ * type:
+ * - chzn::shared_async<T>
+ *   usage:
+ *   - a function return chzn::shared_async<T> is a coroutine, its result can be co_awaited by any number of coroutines;
+ *   - lazy start, start when first co_awaited, then run to the end even if every copy has gone;
+ *   - co_await it to get const T&, valid while a copy of it lives, rethrow if the coroutine throws;
+ *     co_await after it completes is ready at once;
+ *   - awaiters wait in an intrusive list in their own frames, resumed in order of co_await
+ *     by the thread completing it, no frame is created per awaiter;
+ *   - copyable, copies share one frame, destroyed with the last copy, never started if never co_awaited;
+ *   - thread safe, may be co_awaited from any thread;
+ *   - co_await in chzn::task is canceled in place;
+ *   member function:
+ *   - ready()
+ *     true if it has completed;
+ * function:
+ * - chzn::share(chzn::async<T> a)
+ *   return chzn::shared_async<T> awaiting a;
+ * */
+namespace chzn{
+    namespace _detail{
+        template<typename T>
+        struct _shared_async_result{
+            void return_value(T t){value.emplace(std::move(t));}
+
+            std::optional<T> value;
+        };
+
+        template<>
+        struct _shared_async_result<void>{
+            constexpr void return_void() const noexcept{}
+        };
+    }
+
+    template<typename T=void>
+    struct shared_async{
+        struct promise_type:public _detail::_frame_memory,public _detail::_shared_async_result<T>{
+            shared_async get_return_object(){return {handle_type::from_promise(*this)};}
+
+            constexpr std::suspend_always initial_suspend() const noexcept{return {};}
+
+            void unhandled_exception(){error=std::current_exception();}
+
+            // resume every awaiter, the last one by symmetric transfer, frame lives until the last copy and this are done
+            struct suspend_final:public std::suspend_always{
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept{
+                    auto &p=handle.promise();
+                    _detail::_slot_link list;
+                    {
+                        std::lock_guard lock(p.mutex);
+                        p.done.store(true,std::memory_order_release);
+                        while(p.waiters.linked()){
+                            auto &w=*p.waiters.next;
+                            w.erase();
+                            w.last=list.last;
+                            w.next=&list;
+                            list.last->next=&w;
+                            list.last=&w;
+                        }
+                    }
+                    std::coroutine_handle<> last=std::noop_coroutine();
+                    while(list.linked()){
+                        auto &w=static_cast<awaiter &>(*list.next);
+                        w.erase();
+                        if(!list.linked())last=w.handle;
+                        else w.handle.resume();
+                    }
+                    p.release(handle); // the reference of running
+                    return last;
+                }
+            };
+
+            constexpr suspend_final final_suspend() const noexcept{return {};}
+
+            void release(std::coroutine_handle<promise_type> handle) noexcept{
+                if(refs.fetch_sub(1,std::memory_order_acq_rel)==1)handle.destroy();
+            }
+
+            std::exception_ptr error;
+            std::mutex mutex;
+            _detail::_slot_link waiters;
+            std::atomic<std::size_t> refs=1;
+            std::atomic<bool> done=false;
+            bool started=false;
+        };
+
+        using handle_type=std::coroutine_handle<promise_type>;
+        handle_type coroutine;
+
+        struct awaiter:public _detail::_slot_link{
+            handle_type coroutine;
+            std::coroutine_handle<> handle;
+
+            awaiter(handle_type coroutine) noexcept:coroutine(coroutine){}
+
+            awaiter(const awaiter &a) noexcept:_detail::_slot_link(a),coroutine(a.coroutine){}
+
+            ~awaiter(){if(this->linked())await_cancel();}
+
+            bool await_ready() const noexcept{return coroutine.promise().done.load(std::memory_order_acquire);}
+
+            // the first awaiter starts the coroutine
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) noexcept{
+                auto &p=coroutine.promise();
+                std::lock_guard lock(p.mutex);
+                if(p.done.load(std::memory_order_relaxed))return h;
+                handle=h;
+                last=p.waiters.last;
+                next=&p.waiters;
+                p.waiters.last->next=this;
+                p.waiters.last=this;
+                if(p.started)return std::noop_coroutine();
+                p.started=true;
+                p.refs.fetch_add(1,std::memory_order_relaxed);
+                return coroutine;
+            }
+
+            std::add_lvalue_reference_t<const T> await_resume() const{
+                auto &p=coroutine.promise();
+                if(p.error)[[unlikely]]std::rethrow_exception(p.error);
+                if constexpr(!std::is_void_v<T>)return *p.value;
+            }
+
+            void await_cancel() noexcept{
+                std::lock_guard lock(coroutine.promise().mutex);
+                erase();
+            }
+        };
+
+        awaiter operator
+        co_await() const noexcept{
+            return {coroutine};
+        }
+
+        bool ready() const noexcept{return coroutine&&coroutine.promise().done.load(std::memory_order_acquire);}
+
+        ~shared_async(){
+            if(coroutine)coroutine.promise().release(coroutine);
+        }
+
+        shared_async() = default;
+
+        shared_async(handle_type handle):coroutine(handle){}
+
+        shared_async(const shared_async &s) noexcept:coroutine(s.coroutine){
+            if(coroutine)coroutine.promise().refs.fetch_add(1,std::memory_order_relaxed);
+        }
+
+        shared_async(shared_async &&s) noexcept{std::swap(coroutine,s.coroutine);}
+
+        shared_async &operator=(shared_async s) noexcept{
+            std::swap(coroutine,s.coroutine);
+            return *this;
+        }
+    };
+
+    template<typename T>
+    shared_async<T> share(async<T> a){
+        if constexpr(std::is_void_v<T>)co_await std::move(a);
+        else co_return co_await std::move(a);
+    }
+}
+
+
+/*
+ * version 1.15.0 Cache
+ * 2026/10/16
+ * type:
+ * - chzn::eviction_policy
+ *   - lru:   evict the least recently got entry;
+ *   - clock: second chance, a hit only set a bit, cheaper hit, close to lru;
+ * - chzn::async_cache<K,V,Hash=std::hash<K>>
+ *   usage:
+ *   - single flight cache, concurrent get of a missing key share one load, the loader is called once;
+ *   - entries are chzn::shared_async<V>, co_await get(k,loader) to get const V&,
+ *     valid while the returned shared_async lives, even if the entry is evicted;
+ *   - a failed load is not cached, its awaiters rethrow, next get loads again;
+ *   - keys are spread over shards by hash, each shard has a mutex, a map and an eviction list,
+ *     the lock is held only for lookup, never during a load;
+ *   - capacity is split evenly between shards, loading entries are never evicted,
+ *     a shard may exceed its part while they are more than it;
+ *   - ttl counts from the load started, an expired entry is a miss, expire() / expire_every() erase them;
+ *   - thread safe, not copyable, not movable, must outlive loads it started;
+ *   member function:
+ *   - async_cache(std::size_t capacity,eviction_policy policy=lru,duration ttl=0 (never expire),std::size_t shards=0)
+ *     shards=0 means a power of 2 not less than hardware concurrency;
+ *   - get(const K &k,F &&loader)
+ *     return chzn::shared_async<V>, loader(k) is called in the lock on miss and return async<V> or shared_async<V>,
+ *     it should only create the coroutine, which runs when the result is co_awaited;
+ *   - erase(const K &k)
+ *   - clear()
+ *   - size()
+ *   - expire()
+ *     erase expired entries, return how many;
+ *   - expire_every(duration period)
+ *     return chzn::task calling expire() every period by sleep_for, destroy the task to stop;
+ * */
+#include <unordered_map>
+namespace chzn{
+    enum class eviction_policy{
+        lru,
+        clock,
+    };
+
+    template<typename K,typename V,typename Hash=std::hash<K>>
+    struct async_cache{
+        using clock=timer_wheel::clock;
+
+        explicit async_cache(std::size_t capacity,eviction_policy policy=eviction_policy::lru,
+                             clock::duration ttl=clock::duration::zero(),std::size_t shards=0)
+                :policy(policy),ttl(ttl){
+            if(!shards)shards=std::max<std::size_t>(std::thread::hardware_concurrency(),1);
+            shard_count=std::bit_ceil(shards);
+            this->shards=std::make_unique<shard[]>(shard_count);
+            for(std::size_t i=0;i<shard_count;++i)
+                this->shards[i].capacity=std::max<std::size_t>((capacity+shard_count-1)/shard_count,1);
+        }
+
+        async_cache(async_cache &) = delete;
+
+        void operator=(async_cache &) = delete;
+
+        template<typename F>
+        shared_async<V> get(const K &k,F &&loader){
+            auto h=hash(k);
+            auto &s=shard_of(h);
+            std::lock_guard lock(s.mutex);
+            auto it=s.map.find(k);
+            if(it!=s.map.end()){
+                auto &e=it->second;
+                if(!stale(e))[[likely]]{
+                    touch(s,e);
+                    return e.value;
+                }
+                s.remove(it);
+            }
+            it=s.map.try_emplace(k).first;
+            auto &e=it->second;
+            e.key=&it->first;
+            if constexpr(_detail::_is_async<std::invoke_result_t<F &,const K &>>::value)
+                e.value=share(std::invoke(loader,it->first));
+            else e.value=std::invoke(loader,it->first);
+            if(ttl!=clock::duration::zero())e.expiry=clock::now()+ttl;
+            e.last=s.order.last; // newest at the back, or just behind the clock hand
+            e.next=&s.order;
+            if(policy==eviction_policy::clock&&s.hand!=&s.order){
+                e.last=s.hand->last;
+                e.next=s.hand;
+            }
+            e.last->next=&e;
+            e.next->last=&e;
+            while(s.map.size()>s.capacity&&evict(s,&e));
+            return e.value;
+        }
+
+        bool erase(const K &k){
+            auto &s=shard_of(hash(k));
+            std::lock_guard lock(s.mutex);
+            auto it=s.map.find(k);
+            if(it==s.map.end())return false;
+            s.remove(it);
+            return true;
+        }
+
+        void clear(){
+            for(std::size_t i=0;i<shard_count;++i){
+                std::lock_guard lock(shards[i].mutex);
+                shards[i].hand=&shards[i].order;
+                shards[i].map.clear();
+            }
+        }
+
+        std::size_t size() const{
+            std::size_t n=0;
+            for(std::size_t i=0;i<shard_count;++i){
+                std::lock_guard lock(shards[i].mutex);
+                n+=shards[i].map.size();
+            }
+            return n;
+        }
+
+        std::size_t expire(){
+            if(ttl==clock::duration::zero())return 0;
+            std::size_t n=0;
+            auto now=clock::now();
+            for(std::size_t i=0;i<shard_count;++i){
+                auto &s=shards[i];
+                std::lock_guard lock(s.mutex);
+                for(auto it=s.map.begin();it!=s.map.end();){
+                    auto next=std::next(it);
+                    if(it->second.expiry<=now){
+                        s.remove(it);
+                        ++n;
+                    }
+                    it=next;
+                }
+            }
+            return n;
+        }
+
+        template<typename Rep,typename Period>
+        task expire_every(std::chrono::duration<Rep,Period> period){
+            for(;;){
+                co_await sleep_for(period);
+                expire();
+            }
+        }
+
+    private:
+        struct entry:public _detail::_slot_link{
+            const K *key=nullptr;
+            shared_async<V> value;
+            clock::time_point expiry=clock::time_point::max();
+            bool referenced=false; // clock only
+        };
+
+        struct alignas(64) shard{
+            mutable std::mutex mutex;
+            std::unordered_map<K,entry,Hash> map;
+            _detail::_slot_link order; // lru: oldest first; clock: circular with hand
+            _detail::_slot_link *hand=&order;
+            std::size_t capacity=1;
+
+            void remove(typename std::unordered_map<K,entry,Hash>::iterator it){
+                if(hand==&it->second)hand=hand->next;
+                map.erase(it); // entry unlinks itself
+            }
+        };
+
+        eviction_policy policy;
+        clock::duration ttl;
+        std::size_t shard_count;
+        std::unique_ptr<shard[]> shards;
+        [[no_unique_address]] Hash hasher;
+
+        std::size_t hash(const K &k) const{
+            auto h=static_cast<std::size_t>(hasher(k));
+            return h^(h>>17)^(h>>31); // std::hash of integers is identity
+        }
+
+        shard &shard_of(std::size_t h) const noexcept{return shards[h&(shard_count-1)];}
+
+        // expired or failed
+        bool stale(entry &e) const{
+            if(ttl!=clock::duration::zero()&&e.expiry<=clock::now())return true;
+            return e.value.ready()&&e.value.coroutine.promise().error;
+        }
+
+        void touch(shard &s,entry &e) noexcept{
+            if(policy==eviction_policy::clock){
+                e.referenced=true;
+                return;
+            }
+            e.erase();
+            e.last=s.order.last;
+            e.next=&s.order;
+            s.order.last->next=&e;
+            s.order.last=&e;
+        }
+
+        // remove one completed entry but keep, false if all others are loading
+        bool evict(shard &s,const entry *keep){
+            auto &order=s.order;
+            if(policy==eviction_policy::lru){
+                for(auto n=order.next;n!=&order;n=n->next)
+                    if(n!=keep&&static_cast<entry *>(n)->value.ready()){
+                        s.remove(s.map.find(*static_cast<entry *>(n)->key));
+                        return true;
+                    }
+                return false;
+            }
+            // every entry is passed at most twice, once to clear its bit
+            for(std::size_t steps=2*s.map.size()+1;steps--;){
+                if(s.hand==&order){
+                    s.hand=order.next;
+                    if(s.hand==&order)return false;
+                    continue;
+                }
+                auto &e=*static_cast<entry *>(s.hand);
+                s.hand=s.hand->next;
+                if(&e==keep||!e.value.ready())continue;
+                if(std::exchange(e.referenced,false))continue;
+                s.remove(s.map.find(*e.key));
+                return true;
+            }
+            return false;
+        }
+    };
+}
+
+
+/*
+ * version 1.16.0 Task Group
+ * 2026/10/16
+ * type:
+ * - chzn::task_group
+ *   usage:
+ *   - owns spawned chzn::async<T>, runs at most max_concurrency of them at once, others wait in FIFO order
+ *     and start when a running one completes, on its thread;
+ *   - results are dropped, the first exception is kept, then children not started are destroyed without running,
+ *     later spawns are dropped, and running children are detached like losers of when_any:
+ *     join() no longer waits for them, each destroys itself when complete;
+ *     chzn::async has no cancellation point, so a detached child is not interrupted and runs to its end,
+ *     it must not use the group or anything owned by the joiner after canceled() is true;
+ *   - a child arrives at the group at its final suspend, no wrapper frame, its frame is freed at once;
+ *   - thread safe, not copyable, not movable;
+ *   - must outlive its children, co_await join() before destruction, children not started are destroyed with it;
+ *   member function:
+ *   - task_group(std::size_t max_concurrency=unlimited)
+ *   - spawn(async<T> a)
+ *     start a in this thread until it first suspends, or queue it if max_concurrency children are running;
+ *   - join()
+ *     co_await it to wait until all children completed or were detached, rethrow the first exception,
+ *     one joiner at a time;
+ *   - cancel()
+ *     destroy children not started, drop later spawns;
+ *   - canceled()
+ *     true after cancel() or an exception, children may check it to stop early;
+ *   - size()
+ *     children running or waiting, not detached ones;
+ * */
+namespace chzn{
+    struct task_group;
+
+    namespace _detail{
+        struct _group_child:public _frame_memory,public _join_child,public _slot_link{
+            task_group *group;
+            std::coroutine_handle<> coroutine;
+            std::atomic<_join_child *> *join; // of the child promise
+            std::exception_ptr (*error)(std::coroutine_handle<>) noexcept;
+        };
+    }
+
+    struct task_group{
+        explicit task_group(std::size_t max_concurrency=-1):limit(std::max<std::size_t>(max_concurrency,1)){}
+
+        task_group(task_group &) = delete;
+
+        void operator=(task_group &) = delete;
+
+        ~task_group(){
+            _detail::_slot_link dropped;
+            {
+                std::lock_guard lock(mutex);
+                move_pending(dropped);
+            }
+            destroy(dropped);
+        }
+
+        template<typename T>
+        void spawn(async<T> a){
+            auto &n=*new _detail::_group_child;
+            n.group=this;
+            n.on_arrive=&arrive;
+            n.coroutine=std::exchange(a.coroutine,nullptr);
+            n.join=&async<T>::handle_type::from_address(n.coroutine.address()).promise().join;
+            n.error=[](std::coroutine_handle<> h) noexcept{
+                auto &p=async<T>::handle_type::from_address(h.address()).promise();
+                return p.state==_detail::throws?p.error:std::exception_ptr();
+            };
+            n.join->store(&n,std::memory_order_relaxed);
+            std::unique_lock lock(mutex);
+            if(stopped)[[unlikely]]{
+                lock.unlock();
+                n.coroutine.destroy();
+                delete &n;
+                return;
+            }
+            if(running<limit){
+                ++running;
+                push(active,n);
+                auto h=n.coroutine; // n is deleted if a sibling fails and detaches it now
+                lock.unlock();
+                h.resume();
+                return;
+            }
+            push(pending,n);
+            ++waiting;
+        }
+
+        struct join_awaiter{
+            task_group &group;
+
+            bool await_ready(){
+                std::lock_guard lock(group.mutex);
+                return !group.running;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle){
+                std::lock_guard lock(group.mutex);
+                if(!group.running)return false;
+                group.joiner=handle;
+                return true;
+            }
+
+            void await_resume() const{
+                if(group.error)[[unlikely]]std::rethrow_exception(group.error);
+            }
+
+            void await_cancel(){
+                std::lock_guard lock(group.mutex);
+                group.joiner=nullptr;
+            }
+        };
+
+        join_awaiter join() noexcept{return {*this};}
+
+        void cancel(){
+            _detail::_slot_link dropped;
+            {
+                std::lock_guard lock(mutex);
+                stopped=true;
+                move_pending(dropped);
+            }
+            destroy(dropped);
+        }
+
+        bool canceled() const{
+            std::lock_guard lock(mutex);
+            return stopped;
+        }
+
+        std::size_t size() const{
+            std::lock_guard lock(mutex);
+            return running+waiting;
+        }
+
+    private:
+        mutable std::mutex mutex;
+        _detail::_slot_link pending,active; // children waiting to start, and started ones not detached
+        std::size_t limit,running=0,waiting=0;
+        std::exception_ptr error;
+        std::coroutine_handle<> joiner;
+        bool stopped=false;
+
+        static void push(_detail::_slot_link &list,_detail::_slot_link &n) noexcept{
+            n.last=list.last;
+            n.next=&list;
+            list.last->next=&n;
+            list.last=&n;
+        }
+
+        // after the first error, stop waiting for running children, those arriving now are still waited
+        void detach_active() noexcept{
+            for(auto l=active.next;l!=&active;){
+                auto &n=static_cast<_detail::_group_child &>(*l);
+                l=l->next;
+                if(n.join->exchange(&_detail::_join_detached,std::memory_order_acq_rel)==&_detail::_join_arriving)continue;
+                n.erase();
+                --running;
+                delete &n; // the child destroys itself at final suspend
+            }
+        }
+
+        void move_pending(_detail::_slot_link &to) noexcept{
+            if(!pending.linked())return;
+            to.next=pending.next;
+            to.last=pending.last;
+            to.next->last=&to;
+            to.last->next=&to;
+            pending.last=pending.next=&pending;
+            waiting=0;
+        }
+
+        // destroy frames out of the lock, their destructors may spawn
+        static void destroy(_detail::_slot_link &list) noexcept{
+            while(list.linked()){
+                auto &n=static_cast<_detail::_group_child &>(*list.next);
+                n.erase();
+                n.coroutine.destroy();
+                delete &n;
+            }
+        }
+
+        // at final suspend of a child, return the next child to start, or the joiner if it is the last;
+        // it leaves active before its frame is destroyed, a failing sibling may touch its join until then
+        static std::coroutine_handle<> arrive(_detail::_join_child &j) noexcept{
+            auto &n=static_cast<_detail::_group_child &>(j);
+            auto &g=*n.group;
+            auto e=n.error(n.coroutine);
+            _detail::_slot_link dropped;
+            {
+                std::lock_guard lock(g.mutex);
+                n.erase();
+                if(e&&!g.error){
+                    g.error=e;
+                    g.stopped=true;
+                    g.move_pending(dropped);
+                    g.detach_active();
+                }
+            }
+            n.coroutine.destroy();
+            delete &n;
+            destroy(dropped);
+            std::coroutine_handle<> next=std::noop_coroutine();
+            {
+                std::lock_guard lock(g.mutex);
+                if(g.pending.linked()){
+                    auto &p=static_cast<_detail::_group_child &>(*g.pending.next);
+                    p.erase();
+                    --g.waiting;
+                    push(g.active,p);
+                    next=p.coroutine;
+                }else if(!--g.running&&g.joiner)next=std::exchange(g.joiner,nullptr);
+            }
+            return next;
+        }
+    };
+}
+
+
+/*
+ * version 1.17.0 Synchronization
+ * 2026/10/16
+ * type:
+ * - chzn::async_semaphore
+ *   usage:
+ *   - counting semaphore, co_await acquire() suspends instead of blocking the thread;
+ *   - uncontended acquire and release are a single CAS, waiters wait in intrusive lists in their frames,
+ *     in FIFO order, a release hands its permit directly to the first waiter, no barging while there are waiters;
+ *   - a waiter is resumed by the executor current when it co_await, resume inline if there is none;
+ *   - thread safe, not copyable, not movable, co_await in chzn::task is canceled in place;
+ *   member function:
+ *   - async_semaphore(std::size_t count)
+ *   - acquire()
+ *     co_await it to take a permit;
+ *   - try_acquire()
+ *   - release(std::size_t n=1)
+ * - chzn::async_mutex
+ *   usage:
+ *   - a semaphore of one permit, unlock hands the lock to the first waiter;
+ *   member function:
+ *   - lock()
+ *   - try_lock()
+ *   - unlock()
+ *   - scoped_lock()
+ *     co_await it to get an async_mutex::lock_guard, unlock when it destructs, movable;
+ * - chzn::async_shared_mutex
+ *   usage:
+ *   - readers share, writer excludes, FIFO, a reader arriving after a waiting writer waits,
+ *     unlock wakes the first waiting writer, or all readers at the front of the queue;
+ *   member function:
+ *   - lock()/try_lock()/unlock()/scoped_lock()
+ *   - lock_shared()/try_lock_shared()/unlock_shared()/scoped_lock_shared()
+ *     scoped_lock_shared() get an async_shared_mutex::shared_lock_guard;
+ * - chzn::async_latch
+ *   usage:
+ *   - single use, co_await wait() until count_down() reach zero;
+ *   member function:
+ *   - async_latch(std::ptrdiff_t expected)
+ *   - count_down(std::ptrdiff_t n=1)
+ *   - try_wait()
+ *   - wait()
+ *   - arrive_and_wait(std::ptrdiff_t n=1)
+ *     count_down(n) then wait();
+ * - chzn::async_barrier
+ *   usage:
+ *   - reusable, each phase completes when expected participants arrive, the last one resumes the others
+ *     and continues without suspending;
+ *   member function:
+ *   - async_barrier(std::ptrdiff_t expected)
+ *   - arrive_and_wait()
+ *   - arrive_and_drop()
+ *     arrive and leave, expected of later phases decreases by one;
+ * */
+namespace chzn{
+    namespace _detail{
+        struct _sync_waiter:public _slot_link{
+            std::coroutine_handle<> coroutine;
+            executor home;
+            bool shared=false; // async_shared_mutex only
+        };
+
+        // waiters of a primitive, state is changed only under mutex while `waiting` bit is set
+        struct _sync_queue{
+            static constexpr std::size_t waiting=1;
+
+            std::atomic<std::size_t> state;
+            std::mutex mutex;
+            _slot_link waiters;
+
+            explicit _sync_queue(std::size_t state) noexcept:state(state){}
+
+            _sync_waiter &front() noexcept{return static_cast<_sync_waiter &>(*waiters.next);}
+
+            void push(_slot_link &list,_sync_waiter &w) noexcept{
+                w.last=list.last;
+                w.next=&list;
+                list.last->next=&w;
+                list.last=&w;
+            }
+
+            // pop the first waiter to ready
+            void grant(_slot_link &ready) noexcept{
+                auto &w=front();
+                w.erase();
+                push(ready,w);
+                if(!waiters.linked())state.fetch_and(~waiting,std::memory_order_relaxed);
+            }
+
+            // after unlock of mutex
+            static void resume(_slot_link &ready){
+                while(ready.linked()){
+                    auto &w=static_cast<_sync_waiter &>(*ready.next);
+                    w.erase();
+                    w.home.post(w.coroutine); // w may be gone now
+                }
+            }
+
+            // set `waiting` and queue w, state is s, false if s changed
+            bool park(_sync_waiter &w,std::size_t s) noexcept{
+                if(!(s&waiting)&&!state.compare_exchange_weak(s,s|waiting,std::memory_order_relaxed))return false;
+                push(waiters,w);
+                return true;
+            }
+        };
+
+        // awaiter of a primitive P, P::take(s,shared) is the fast path, P::dispatch(ready) grants waiters in lock
+        template<typename P>
+        struct _sync_awaiter:public _sync_waiter{
+            P &p;
+
+            _sync_awaiter(P &p,bool shared=false) noexcept:p(p){this->shared=shared;}
+
+            _sync_awaiter(const _sync_awaiter &a) noexcept:_sync_waiter(a),p(a.p){}
+
+            ~_sync_awaiter(){if(this->linked())await_cancel();}
+
+            bool await_ready() noexcept{return p.try_take(this->shared);}
+
+            bool await_suspend(std::coroutine_handle<> handle){
+                coroutine=handle;
+                home=current_executor();
+                std::lock_guard lock(p.queue.mutex);
+                for(;;){
+                    auto s=p.queue.state.load(std::memory_order_relaxed);
+                    if(!(s&_sync_queue::waiting)&&P::can_take(s,this->shared)){
+                        if(p.queue.state.compare_exchange_weak(s,P::take(s,this->shared),std::memory_order_acquire))return false;
+                        continue;
+                    }
+                    if(p.queue.park(*this,s))return true;
+                }
+            }
+
+            static void await_resume() noexcept{}
+
+            void await_cancel(){
+                _slot_link ready;
+                {
+                    std::lock_guard lock(p.queue.mutex);
+                    if(!this->linked())return;
+                    this->erase();
+                    if(!p.queue.waiters.linked())p.queue.state.fetch_and(~_sync_queue::waiting,std::memory_order_relaxed);
+                    p.dispatch(ready); // a canceled writer may unblock readers behind it
+                }
+                _sync_queue::resume(ready);
+            }
+        };
+    }
+
+    struct async_semaphore{
+        explicit async_semaphore(std::size_t count) noexcept:queue(count*unit){}
+
+        async_semaphore(async_semaphore &) = delete;
+
+        void operator=(async_semaphore &) = delete;
+
+        bool try_acquire() noexcept{return try_take(false);}
+
+        _detail::_sync_awaiter<async_semaphore> acquire() noexcept{return {*this};}
+
+        void release(std::size_t n=1){
+            auto s=queue.state.load(std::memory_order_relaxed);
+            while(!(s&_detail::_sync_queue::waiting))
+                if(queue.state.compare_exchange_weak(s,s+n*unit,std::memory_order_release,std::memory_order_relaxed))return;
+            _detail::_slot_link ready;
+            {
+                std::lock_guard lock(queue.mutex);
+                queue.state.fetch_add(n*unit,std::memory_order_relaxed);
+                dispatch(ready);
+            }
+            _detail::_sync_queue::resume(ready);
+        }
+
+    private:
+        friend _detail::_sync_awaiter<async_semaphore>;
+        static constexpr std::size_t unit=2;
+
+        _detail::_sync_queue queue;
+
+        static bool can_take(std::size_t s,bool) noexcept{return s>=unit;}
+
+        static std::size_t take(std::size_t s,bool) noexcept{return s-unit;}
+
+        bool try_take(bool) noexcept{
+            auto s=queue.state.load(std::memory_order_relaxed);
+            while(!(s&_detail::_sync_queue::waiting)&&s>=unit)
+                if(queue.state.compare_exchange_weak(s,s-unit,std::memory_order_acquire,std::memory_order_relaxed))return true;
+            return false;
+        }
+
+        // hand permits to waiters
+        void dispatch(_detail::_slot_link &ready) noexcept{
+            while(queue.waiters.linked()&&queue.state.load(std::memory_order_relaxed)>=unit){
+                queue.state.fetch_sub(unit,std::memory_order_relaxed);
+                queue.grant(ready);
+            }
+        }
+    };
+
+    struct async_mutex{
+        struct lock_guard{
+            async_mutex *mutex=nullptr;
+
+            lock_guard() = default;
+
+            explicit lock_guard(async_mutex &m) noexcept:mutex(&m){}
+
+            lock_guard(lock_guard &&g) noexcept:mutex(std::exchange(g.mutex,nullptr)){}
+
+            lock_guard &operator=(lock_guard g) noexcept{
+                std::swap(mutex,g.mutex);
+                return *this;
+            }
+
+            ~lock_guard(){if(mutex)mutex->unlock();}
+        };
+
+        struct scoped_lock_awaiter:public _detail::_sync_awaiter<async_semaphore>{
+            async_mutex &m;
+
+            lock_guard await_resume() const noexcept{return lock_guard(m);}
+        };
+
+        async_mutex() noexcept:semaphore(1){}
+
+        bool try_lock() noexcept{return semaphore.try_acquire();}
+
+        _detail::_sync_awaiter<async_semaphore> lock() noexcept{return semaphore.acquire();}
+
+        scoped_lock_awaiter scoped_lock() noexcept{return {{semaphore},*this};}
+
+        void unlock(){semaphore.release();}
+
+    private:
+        async_semaphore semaphore;
+    };
+
+    struct async_shared_mutex{
+        struct lock_guard{
+            async_shared_mutex *mutex=nullptr;
+
+            lock_guard() = default;
+
+            explicit lock_guard(async_shared_mutex &m) noexcept:mutex(&m){}
+
+            lock_guard(lock_guard &&g) noexcept:mutex(std::exchange(g.mutex,nullptr)){}
+
+            lock_guard &operator=(lock_guard g) noexcept{
+                std::swap(mutex,g.mutex);
+                return *this;
+            }
+
+            ~lock_guard(){if(mutex)mutex->unlock();}
+        };
+
+        struct shared_lock_guard{
+            async_shared_mutex *mutex=nullptr;
+
+            shared_lock_guard() = default;
+
+            explicit shared_lock_guard(async_shared_mutex &m) noexcept:mutex(&m){}
+
+            shared_lock_guard(shared_lock_guard &&g) noexcept:mutex(std::exchange(g.mutex,nullptr)){}
+
+            shared_lock_guard &operator=(shared_lock_guard g) noexcept{
+                std::swap(mutex,g.mutex);
+                return *this;
+            }
+
+            ~shared_lock_guard(){if(mutex)mutex->unlock_shared();}
+        };
+
+        template<typename Guard>
+        struct scoped_awaiter:public _detail::_sync_awaiter<async_shared_mutex>{
+            Guard await_resume() const noexcept{return Guard(p);}
+        };
+
+        async_shared_mutex() noexcept:queue(0){}
+
+        async_shared_mutex(async_shared_mutex &) = delete;
+
+        void operator=(async_shared_mutex &) = delete;
+
+        bool try_lock() noexcept{return try_take(false);}
+
+        bool try_lock_shared() noexcept{return try_take(true);}
+
+        _detail::_sync_awaiter<async_shared_mutex> lock() noexcept{return {*this,false};}
+
+        _detail::_sync_awaiter<async_shared_mutex> lock_shared() noexcept{return {*this,true};}
+
+        scoped_awaiter<lock_guard> scoped_lock() noexcept{return {{*this,false}};}
+
+        scoped_awaiter<shared_lock_guard> scoped_lock_shared() noexcept{return {{*this,true}};}
+
+        void unlock(){
+            auto s=writer;
+            if(queue.state.compare_exchange_strong(s,0,std::memory_order_release,std::memory_order_relaxed))return;
+            release(writer);
+        }
+
+        void unlock_shared(){
+            auto s=queue.state.load(std::memory_order_relaxed);
+            while(!(s&_detail::_sync_queue::waiting))
+                if(queue.state.compare_exchange_weak(s,s-reader,std::memory_order_release,std::memory_order_relaxed))return;
+            release(reader);
+        }
+
+    private:
+        friend _detail::_sync_awaiter<async_shared_mutex>;
+        static constexpr std::size_t writer=2,reader=4; // state: readers*reader|writer|waiting
+
+        _detail::_sync_queue queue;
+
+        static bool can_take(std::size_t s,bool shared) noexcept{return shared?!(s&writer):!s;}
+
+        static std::size_t take(std::size_t s,bool shared) noexcept{return shared?s+reader:s|writer;}
+
+        bool try_take(bool shared) noexcept{
+            auto s=queue.state.load(std::memory_order_relaxed);
+            while(!(s&_detail::_sync_queue::waiting)&&can_take(s,shared))
+                if(queue.state.compare_exchange_weak(s,take(s,shared),std::memory_order_acquire,std::memory_order_relaxed))return true;
+            return false;
+        }
+
+        void release(std::size_t held){
+            _detail::_slot_link ready;
+            {
+                std::lock_guard lock(queue.mutex);
+                queue.state.fetch_sub(held,std::memory_order_relaxed);
+                dispatch(ready);
+            }
+            _detail::_sync_queue::resume(ready);
+        }
+
+        // first writer alone, or readers at front together
+        void dispatch(_detail::_slot_link &ready) noexcept{
+            while(queue.waiters.linked()){
+                auto s=queue.state.load(std::memory_order_relaxed);
+                if(queue.front().shared){
+                    if(s&writer)break;
+                    queue.state.fetch_add(reader,std::memory_order_relaxed);
+                }else{
+                    if(s&~_detail::_sync_queue::waiting)break;
+                    queue.state.fetch_or(writer,std::memory_order_relaxed);
+                }
+                queue.grant(ready);
+            }
+        }
+    };
+
+    struct async_latch{
+        explicit async_latch(std::ptrdiff_t expected) noexcept:count(expected){}
+
+        async_latch(async_latch &) = delete;
+
+        void operator=(async_latch &) = delete;
+
+        void count_down(std::ptrdiff_t n=1){
+            if(count.fetch_sub(n,std::memory_order_acq_rel)!=n)return;
+            _detail::_slot_link ready;
+            {
+                std::lock_guard lock(mutex);
+                while(waiters.linked()){
+                    auto &w=*waiters.next;
+                    w.erase();
+                    w.last=ready.last;
+                    w.next=&ready;
+                    ready.last->next=&w;
+                    ready.last=&w;
+                }
+            }
+            _detail::_sync_queue::resume(ready);
+        }
+
+        bool try_wait() const noexcept{return count.load(std::memory_order_acquire)<=0;}
+
+        struct wait_awaiter:public _detail::_sync_waiter{
+            async_latch &latch;
+
+            wait_awaiter(async_latch &l) noexcept:latch(l){}
+
+            wait_awaiter(const wait_awaiter &a) noexcept:_detail::_sync_waiter(a),latch(a.latch){}
+
+            ~wait_awaiter(){if(this->linked())await_cancel();}
+
+            bool await_ready() const noexcept{return latch.try_wait();}
+
+            bool await_suspend(std::coroutine_handle<> handle){
+                coroutine=handle;
+                home=current_executor();
+                std::lock_guard lock(latch.mutex);
+                if(latch.try_wait())return false;
+                last=latch.waiters.last;
+                next=&latch.waiters;
+                latch.waiters.last->next=this;
+                latch.waiters.last=this;
+                return true;
+            }
+
+            static void await_resume() noexcept{}
+
+            void await_cancel(){
+                std::lock_guard lock(latch.mutex);
+                erase();
+            }
+        };
+
+        wait_awaiter wait() noexcept{return {*this};}
+
+        wait_awaiter arrive_and_wait(std::ptrdiff_t n=1){
+            count_down(n);
+            return {*this};
+        }
+
+    private:
+        std::atomic<std::ptrdiff_t> count;
+        std::mutex mutex;
+        _detail::_slot_link waiters;
+    };
+
+    struct async_barrier{
+        explicit async_barrier(std::ptrdiff_t expected) noexcept:expected(expected),remaining(expected){}
+
+        async_barrier(async_barrier &) = delete;
+
+        void operator=(async_barrier &) = delete;
+
+        struct arrive_awaiter:public _detail::_sync_waiter{
+            async_barrier &barrier;
+
+            arrive_awaiter(async_barrier &b) noexcept:barrier(b){}
+
+            arrive_awaiter(const arrive_awaiter &a) noexcept:_detail::_sync_waiter(a),barrier(a.barrier){}
+
+            ~arrive_awaiter(){if(this->linked())await_cancel();}
+
+            static constexpr bool await_ready() noexcept{return false;}
+
+            // the last one completes the phase and does not suspend
+            bool await_suspend(std::coroutine_handle<> handle){
+                coroutine=handle;
+                home=current_executor();
+                _detail::_slot_link ready;
+                {
+                    std::lock_guard lock(barrier.mutex);
+                    if(!barrier.arrive(ready)){
+                        last=barrier.waiters.last;
+                        next=&barrier.waiters;
+                        barrier.waiters.last->next=this;
+                        barrier.waiters.last=this;
+                        return true;
+                    }
+                }
+                _detail::_sync_queue::resume(ready);
+                return false;
+            }
+
+            static void await_resume() noexcept{}
+
+            // leave without arriving, the phase still needs one
+            void await_cancel(){
+                std::lock_guard lock(barrier.mutex);
+                if(!linked())return;
+                erase();
+                ++barrier.remaining;
+            }
+        };
+
+        arrive_awaiter arrive_and_wait() noexcept{return {*this};}
+
+        void arrive_and_drop(){
+            _detail::_slot_link ready;
+            {
+                std::lock_guard lock(mutex);
+                --expected;
+                arrive(ready);
+            }
+            _detail::_sync_queue::resume(ready);
+        }
+
+    private:
+        std::mutex mutex;
+        _detail::_slot_link waiters;
+        std::ptrdiff_t expected,remaining;
+
+        // true if the phase completes, waiters are moved to ready
+        bool arrive(_detail::_slot_link &ready) noexcept{
+            if(--remaining>0)return false;
+            remaining=expected;
+            while(waiters.linked()){
+                auto &w=*waiters.next;
+                w.erase();
+                w.last=ready.last;
+                w.next=&ready;
+                ready.last->next=&w;
+                ready.last=&w;
+            }
+            return true;
+        }
+    };
+}
+
+
+/*
+ * version 1.18.0 Trace
+ * 2026/10/16
+ * type:
+ * - chzn::trace_kind
+ *   - create/destroy: a coroutine frame of this library is allocated/freed;
+ *   - first_resume: an async starts when co_awaited, a task starts at once;
+ *   - suspend: a coroutine suspends on an awaitable, what is its type, or "final_suspend";
+ *   - resume: it resumes;
+ * - chzn::trace_event
+ *   usage:
+ *   - time in steady_clock nanoseconds, frame address, what (nullptr if none), kind, thread index;
+ *   - recorded by time stamp counter on x86 (GCC, Clang, MSVC), converted when exported;
+ * function:
+ * - chzn::trace_record(trace_kind kind,const void *frame,const char *what)
+ *   record an event to the ring of this thread, lock free, what must outlive the trace (a string literal);
+ *   a ring keeps the latest CHZN_ASYNC_TRACE_CAPACITY (default 65536, power of 2) events,
+ *   a ring of an exited thread is kept and reused by a later thread, with the same thread index;
+ * - chzn::trace_events()
+ *   std::vector<trace_event> recorded by all threads, in order within a thread;
+ *   events overwritten while it copies a ring are dropped, recording threads are never blocked;
+ * - chzn::chrome_trace()
+ *   std::string of Chrome trace JSON, for chrome://tracing or ui.perfetto.dev;
+ *   each resume to suspend of a coroutine is a slice named by its frame, with the awaited type in args,
+ *   create/destroy are instant events;
+ * - chzn::clear_trace()
+ *   drop events recorded so far;
+ * changes:
+ * - define CHZN_ASYNC_TRACE before include to record events in async, task and notifier:
+ *   frame create/destroy, first resume, final suspend, and suspend/resume on co_await of async and notifier
+ *   in any coroutine, on any co_await in task; without it the hooks expand to nothing;
+ * - awaited types are named from __PRETTY_FUNCTION__ on GCC and Clang, __FUNCSIG__ on MSVC,
+ *   typeid(T).name() elsewhere with RTTI, or "awaitable" without it;
+ * */
+#ifndef CHZN_ASYNC_TRACE_CAPACITY
+#define CHZN_ASYNC_TRACE_CAPACITY 65536
+#endif
+#include <string>
+#include <string_view>
+#include <cstdio>
+#if defined(__x86_64__)||defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64)||defined(_M_IX86)
+#include <intrin.h>
+#endif
+namespace chzn{
+    struct trace_event{
+        std::uint64_t time;
+        const void *frame;
+        const char *what;
+        trace_kind kind;
+        std::uint32_t thread;
+    };
+
+    namespace _detail{
+        // time stamp counter where there is one, converted to steady_clock when exported
+        struct _trace_clock{
+            std::uint64_t ticks;
+            std::chrono::steady_clock::time_point time;
+
+            static std::uint64_t now() noexcept{
+#if defined(__x86_64__)||defined(__i386__)||defined(_M_X64)||defined(_M_IX86)
+                return __rdtsc();
+#else
+                return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+            }
+
+            static _trace_clock sample() noexcept{return {now(),std::chrono::steady_clock::now()};}
+        };
+
+        // ticks to steady_clock nanoseconds, by start and a sample at least 1ms later
+        struct _trace_time_converter{
+            _trace_clock start,end;
+            double ns_per_tick;
+
+            explicit _trace_time_converter(_trace_clock start):start(start),end(_trace_clock::sample()){
+                while(end.time-start.time<std::chrono::milliseconds(1))end=_trace_clock::sample();
+                ns_per_tick=std::chrono::duration<double,std::nano>(end.time-start.time).count()
+                            /static_cast<double>(end.ticks-start.ticks);
+            }
+
+            std::uint64_t operator()(std::uint64_t ticks) const noexcept{
+                auto d=static_cast<double>(static_cast<std::int64_t>(ticks-start.ticks))*ns_per_tick;
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(start.time.time_since_epoch()).count()
+                       +static_cast<std::int64_t>(d);
+            }
+        };
+
+        struct _trace_ring{
+            static constexpr std::uint64_t capacity=CHZN_ASYNC_TRACE_CAPACITY;
+            static_assert(capacity&&!(capacity&(capacity-1)),"CHZN_ASYNC_TRACE_CAPACITY must be a power of 2");
+
+            // written only by the owner thread, atomic so that export reading it is not a data race
+            struct entry{
+                std::atomic<std::uint64_t> time;
+                std::atomic<const void *> frame;
+                std::atomic<const char *> what;
+                std::atomic<trace_kind> kind;
+            };
+
+            std::unique_ptr<entry[]> entries=std::make_unique<entry[]>(capacity);
+            std::atomic<std::uint64_t> head=0; // events ever recorded
+            std::atomic<std::uint64_t> tail=0; // events before it are cleared
+            std::uint32_t thread=0;
+            bool owned=false; // guarded by registry mutex
+        };
+
+        // never destroyed, frames may be freed by static destructors
+        struct _trace_registry{
+            std::mutex mutex;
+            std::vector<std::unique_ptr<_trace_ring>> rings;
+            _trace_clock start=_trace_clock::sample();
+
+            static _trace_registry &instance(){
+                static auto r=new _trace_registry;
+                return *r;
+            }
+
+            _trace_ring *acquire(){
+                std::lock_guard lock(mutex);
+                for(auto &r:rings)
+                    if(!r->owned){
+                        r->owned=true;
+                        return r.get();
+                    }
+                auto &r=rings.emplace_back(std::make_unique<_trace_ring>());
+                r->thread=static_cast<std::uint32_t>(rings.size()-1);
+                r->owned=true;
+                return r.get();
+            }
+
+            void release(_trace_ring *r){
+                std::lock_guard lock(mutex);
+                r->owned=false;
+            }
+        };
+
+        // trivially destructible, usable in destructors of other thread_local objects
+        struct _trace_thread{
+            _trace_ring *ring=nullptr;
+            bool exited=false;
+
+            static _trace_thread &local() noexcept{
+                thread_local _trace_thread t;
+                return t;
+            }
+        };
+
+        struct _trace_release{
+            ~_trace_release(){
+                auto &t=_trace_thread::local();
+                t.exited=true;
+                _trace_registry::instance().release(std::exchange(t.ring,nullptr));
+            }
+        };
+
+        inline _trace_ring *_trace_acquire() noexcept{
+            auto &t=_trace_thread::local();
+            if(t.exited)return nullptr;
+            t.ring=_trace_registry::instance().acquire();
+            thread_local _trace_release release;
+            return t.ring;
+        }
+
+        // "... [with T = name]" or "... [T = name]" or "... _type_name<name>(void)" to name, others as they are
+        inline std::string_view _trace_type_name(std::string_view what) noexcept{
+            if(auto begin=what.find("T = ");begin!=what.npos){
+                what.remove_prefix(begin+4);
+                return what.substr(0,what.rfind(']'));
+            }
+            if(auto begin=what.find("_type_name<");begin!=what.npos){
+                what.remove_prefix(begin+11);
+                what=what.substr(0,what.rfind(">("));
+                for(std::string_view tag:{"class ","struct "})
+                    if(what.starts_with(tag))what.remove_prefix(tag.size());
+                return what;
+            }
+            return what;
+        }
+
+        inline void _trace_json_string(std::string &out,std::string_view s){
+            out+='"';
+            for(char c:s){
+                if(c=='"'||c=='\\')out+='\\';
+                out+=c;
+            }
+            out+='"';
+        }
+    }
+
+    inline void trace_record(trace_kind kind,const void *frame,const char *what) noexcept{
+        auto ring=_detail::_trace_thread::local().ring;
+        if(!ring)[[unlikely]]
+            if(!(ring=_detail::_trace_acquire()))return;
+        auto h=ring->head.load(std::memory_order_relaxed);
+        auto &e=ring->entries[h&(ring->capacity-1)];
+        e.time.store(_detail::_trace_clock::now(),std::memory_order_relaxed);
+        e.frame.store(frame,std::memory_order_relaxed);
+        e.what.store(what,std::memory_order_relaxed);
+        e.kind.store(kind,std::memory_order_relaxed);
+        ring->head.store(h+1,std::memory_order_release);
+    }
+
+    inline std::vector<trace_event> trace_events(){
+        auto &registry=_detail::_trace_registry::instance();
+        _detail::_trace_time_converter to_ns(registry.start);
+        std::lock_guard lock(registry.mutex);
+        std::vector<trace_event> events;
+        for(auto &r:registry.rings){
+            auto capacity=r->capacity;
+            auto head=r->head.load(std::memory_order_acquire);
+            auto begin=std::max(r->tail.load(std::memory_order_relaxed),head>capacity?head-capacity:0);
+            auto first=events.size();
+            for(auto i=begin;i<head;++i){
+                auto &e=r->entries[i&(capacity-1)];
+                events.push_back({to_ns(e.time.load(std::memory_order_relaxed)),e.frame.load(std::memory_order_relaxed),
+                                  e.what.load(std::memory_order_relaxed),e.kind.load(std::memory_order_relaxed),r->thread});
+            }
+            // drop what the owner overwrote meanwhile
+            std::atomic_thread_fence(std::memory_order_acquire);
+            auto now=r->head.load(std::memory_order_relaxed)+1; // the owner may be writing entry of index head
+            if(now-begin>capacity){
+                auto lost=std::min<std::uint64_t>(now-capacity-begin,head-begin);
+                events.erase(events.begin()+static_cast<std::ptrdiff_t>(first),events.begin()+static_cast<std::ptrdiff_t>(first+lost));
+            }
+        }
+        return events;
+    }
+
+    inline void clear_trace(){
+        auto &registry=_detail::_trace_registry::instance();
+        std::lock_guard lock(registry.mutex);
+        for(auto &r:registry.rings)r->tail.store(r->head.load(std::memory_order_acquire),std::memory_order_relaxed);
+    }
+
+    inline std::string chrome_trace(){
+        auto events=trace_events();
+        std::string out="{\"traceEvents\":[";
+        bool first=true;
+        char buffer[128];
+        auto begin=[&](const char *name,const void *frame,const char *phase,std::uint32_t thread,std::uint64_t time){
+            if(!first)out+=",\n";
+            first=false;
+            out+="{\"name\":";
+            if(name)_detail::_trace_json_string(out,name);
+            else{
+                std::snprintf(buffer,sizeof(buffer),"\"%p\"",frame);
+                out+=buffer;
+            }
+            std::snprintf(buffer,sizeof(buffer),",\"ph\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",phase,thread,time/1000.0);
+            out+=buffer;
+        };
+        // open slices of a thread, by frame
+        std::unordered_map<std::uint64_t,std::unordered_map<const void *,std::uint64_t>> running;
+        for(auto &e:events){
+            switch(e.kind){
+                case trace_kind::create:
+                case trace_kind::destroy:
+                    begin(e.kind==trace_kind::create?"create":"destroy",e.frame,"i",e.thread,e.time);
+                    std::snprintf(buffer,sizeof(buffer),",\"s\":\"t\",\"args\":{\"frame\":\"%p\"}}",e.frame);
+                    out+=buffer;
+                    break;
+                case trace_kind::first_resume:
+                case trace_kind::resume:
+                    running[e.thread][e.frame]=e.time;
+                    break;
+                case trace_kind::suspend:{
+                    auto &open=running[e.thread];
+                    auto it=open.find(e.frame);
+                    if(it==open.end())break; // resumed before the trace
+                    begin(nullptr,e.frame,"X",e.thread,it->second);
+                    std::snprintf(buffer,sizeof(buffer),",\"dur\":%.3f,\"args\":{\"await\":",(e.time-it->second)/1000.0);
+                    out+=buffer;
+                    _detail::_trace_json_string(out,e.what?_detail::_trace_type_name(e.what):"");
+                    out+="}}";
+                    open.erase(it);
+                    break;
+                }
+            }
+        }
+        out+="]}\n";
+        return out;
+    }
+}
+
+
+/*
+ * version 1.19.0 Stats
+ * 2026/10/16
+ * type:
+ * - chzn::stats::histogram
+ *   usage:
+ *   - log linear histogram of unsigned values, 8 buckets per power of 2, relative error under 12.5%;
+ *   member function:
+ *   - add(std::uint64_t v,std::uint64_t n=1)
+ *   - count()
+ *   - percentile(double p)
+ *     a value not less than p (0~100) percent of values, the upper bound of its bucket, 0 if empty;
+ *   static member function:
+ *   - bucket(std::uint64_t v)
+ *   - lowest(std::size_t bucket)/highest(std::size_t bucket)
+ * - chzn::stats::resume_latency
+ *   - awaitable: name of the awaited type;
+ *   - ns: histogram of nanoseconds from suspend to resume;
+ * - chzn::stats::report
+ *   - live_frames/live_frame_bytes: coroutine frames allocated by this library and not freed yet, and their size;
+ *   - frames: frames ever allocated;
+ *   - adopted: frames kept running by unowned_promise, of async destructed before done, and of awaits of canceled task;
+ *   - notifies: count of notify of chzn::notifier;
+ *   - notify_fanout: histogram of waiters resumed by each notify;
+ *   - waiters: coroutines and when_all/when_any children waiting on a notifier now,
+ *     including notified ones not resumed yet, divide by notifiers in use for waiters per notifier;
+ *   - latency: per awaitable type, empty unless CHZN_ASYNC_STATS_LATENCY is defined;
+ * constant:
+ * - chzn::stats::enabled
+ *   false if CHZN_ASYNC_NO_STATS is defined, then all counters of report stay 0;
+ * - chzn::stats::latency_enabled
+ *   true if CHZN_ASYNC_STATS_LATENCY is defined;
+ * function:
+ * - chzn::stats::snapshot()
+ *   sum of counters of all threads, read without blocking them, counters are not taken at one instant;
+ * changes:
+ * - counters are always on, each thread updates its own shard with relaxed atomics, no shared cache line;
+ *   a shard of an exited thread is kept and reused by a later thread;
+ *   define CHZN_ASYNC_NO_STATS before include to turn them off;
+ * - define CHZN_ASYNC_STATS_LATENCY before include to time suspend to resume of co_await of async and notifier
+ *   in any coroutine and of any co_await in task, two reads of time stamp counter per suspend;
+ * */
+namespace chzn{
+    namespace stats{
+        struct histogram{
+            static constexpr std::size_t sub_buckets=8,buckets=16+59*sub_buckets+8;
+
+            std::uint64_t counts[buckets]{};
+
+            // values under 16 are exact, then 8 buckets per power of 2
+            static constexpr std::size_t bucket(std::uint64_t v) noexcept{
+                if(v<16)return static_cast<std::size_t>(v);
+                auto e=static_cast<std::size_t>(std::bit_width(v))-4;
+                return 16+(e-1)*sub_buckets+static_cast<std::size_t>(v>>e)-sub_buckets;
+            }
+
+            static constexpr std::uint64_t lowest(std::size_t bucket) noexcept{
+                if(bucket<16)return bucket;
+                auto e=(bucket-16)/sub_buckets+1;
+                return std::uint64_t((bucket-16)%sub_buckets+sub_buckets)<<e;
+            }
+
+            static constexpr std::uint64_t highest(std::size_t bucket) noexcept{
+                return bucket+1<buckets?lowest(bucket+1)-1:~std::uint64_t(0);
+            }
+
+            void add(std::uint64_t v,std::uint64_t n=1) noexcept{counts[bucket(v)]+=n;}
+
+            std::uint64_t count() const noexcept{
+                std::uint64_t n=0;
+                for(auto c:counts)n+=c;
+                return n;
+            }
+
+            std::uint64_t percentile(double p) const noexcept{
+                auto n=count();
+                if(!n)return 0;
+                auto target=std::max<std::uint64_t>(1,static_cast<std::uint64_t>(static_cast<double>(n)*p/100.0+0.5));
+                std::uint64_t seen=0;
+                for(std::size_t b=0;b<buckets;++b)
+                    if((seen+=counts[b])>=target)return highest(b);
+                return highest(buckets-1);
+            }
+        };
+
+        struct resume_latency{
+            std::string awaitable;
+            histogram ns;
+        };
+
+        struct report{
+            std::int64_t live_frames=0;
+            std::int64_t live_frame_bytes=0;
+            std::uint64_t frames=0;
+            std::uint64_t adopted=0;
+            std::uint64_t notifies=0;
+            histogram notify_fanout;
+            std::int64_t waiters=0;
+            std::vector<resume_latency> latency;
+        };
+
+#ifdef CHZN_ASYNC_NO_STATS
+        inline constexpr bool enabled=false;
+#else
+        inline constexpr bool enabled=true;
+#endif
+#ifdef CHZN_ASYNC_STATS_LATENCY
+        inline constexpr bool latency_enabled=true;
+#else
+        inline constexpr bool latency_enabled=false;
+#endif
+    }
+
+    namespace _detail{
+        // single writer, add by load and store
+        template<typename T>
+        void _stats_add(std::atomic<T> &a,T d) noexcept{
+            a.store(a.load(std::memory_order_relaxed)+d,std::memory_order_relaxed);
+        }
+
+        struct _stats_histogram{
+            std::atomic<std::uint64_t> counts[stats::histogram::buckets]{};
+
+            void add(std::uint64_t v) noexcept{_stats_add<std::uint64_t>(counts[stats::histogram::bucket(v)],1);}
+
+            void read(stats::histogram &h) const noexcept{
+                for(std::size_t b=0;b<stats::histogram::buckets;++b)h.counts[b]+=counts[b].load(std::memory_order_relaxed);
+            }
+        };
+
+        struct _stats_shard{
+            std::atomic<std::int64_t> live_frames=0,live_frame_bytes=0,waiters=0;
+            std::atomic<std::uint64_t> frames=0,adopted=0,notifies=0;
+            _stats_histogram fanout;
+#ifdef CHZN_ASYNC_STATS_LATENCY
+            // open addressing by name pointer, a histogram is published before its name
+            struct latency_slot{
+                std::atomic<const char *> what=nullptr;
+                std::atomic<_stats_histogram *> ticks=nullptr;
+            };
+            static constexpr std::size_t latency_slots=64;
+            latency_slot latency[latency_slots];
+
+            void record_latency(const char *what,std::uint64_t ticks){
+                auto h=std::hash<const void *>{}(what);
+                for(std::size_t i=0;i<latency_slots;++i){
+                    auto &slot=latency[(h+i)%latency_slots];
+                    auto w=slot.what.load(std::memory_order_relaxed);
+                    if(!w){
+                        slot.ticks.store(new _stats_histogram,std::memory_order_relaxed);
+                        slot.what.store(w=what,std::memory_order_release);
+                    }
+                    if(w==what)return slot.ticks.load(std::memory_order_relaxed)->add(ticks);
+                }
+                // full, dropped
+            }
+#endif
+            bool owned=false; // guarded by registry mutex
+        };
+
+        // never destroyed, frames may be freed by static destructors
+        struct _stats_registry{
+            std::mutex mutex;
+            std::vector<std::unique_ptr<_stats_shard>> shards;
+            _stats_shard orphan; // for threads after their shard is released, guarded by mutex
+            _trace_clock start=_trace_clock::sample();
+
+            static _stats_registry &instance(){
+                static auto r=new _stats_registry;
+                return *r;
+            }
+
+            _stats_shard *acquire(){
+                std::lock_guard lock(mutex);
+                for(auto &s:shards)
+                    if(!s->owned){
+                        s->owned=true;
+                        return s.get();
+                    }
+                auto &s=shards.emplace_back(std::make_unique<_stats_shard>());
+                s->owned=true;
+                return s.get();
+            }
+
+            void release(_stats_shard *s){
+                std::lock_guard lock(mutex);
+                s->owned=false;
+            }
+        };
+
+        // trivially destructible, usable in destructors of other thread_local objects
+        struct _stats_thread{
+            _stats_shard *shard=nullptr;
+            bool exited=false;
+
+            static _stats_thread &local() noexcept{
+                thread_local _stats_thread t;
+                return t;
+            }
+        };
+
+        struct _stats_release{
+            ~_stats_release(){
+                auto &t=_stats_thread::local();
+                t.exited=true;
+                _stats_registry::instance().release(std::exchange(t.shard,nullptr));
+            }
+        };
+
+        // first update of a thread, or after its shard is released, kept out of line of the hooks
+        inline void _stats_update_slow(void (*f)(void *,_stats_shard &),void *context) noexcept{
+            auto &t=_stats_thread::local();
+            auto &registry=_stats_registry::instance();
+            if(!t.exited){
+                t.shard=registry.acquire();
+                thread_local _stats_release release;
+                return f(context,*t.shard);
+            }
+            std::lock_guard lock(registry.mutex);
+            f(context,registry.orphan);
+        }
+
+        template<typename F>
+        void _stats_update(F f) noexcept{
+            if(auto shard=_stats_thread::local().shard)[[likely]]return f(*shard);
+            _stats_update_slow([](void *f,_stats_shard &s){(*static_cast<F *>(f))(s);},&f);
+        }
+
+        inline void _stats_frame([[maybe_unused]] std::ptrdiff_t count,[[maybe_unused]] std::ptrdiff_t bytes) noexcept{
+#ifndef CHZN_ASYNC_NO_STATS
+            _stats_update([&](_stats_shard &s){
+                _stats_add<std::int64_t>(s.live_frames,count);
+                _stats_add<std::int64_t>(s.live_frame_bytes,bytes);
+                if(count>0)_stats_add<std::uint64_t>(s.frames,1);
+            });
+#endif
+        }
+
+        inline void _stats_adopted() noexcept{
+#ifndef CHZN_ASYNC_NO_STATS
+            _stats_update([](_stats_shard &s){_stats_add<std::uint64_t>(s.adopted,1);});
+#endif
+        }
+
+        inline void _stats_notify([[maybe_unused]] std::size_t fanout) noexcept{
+#ifndef CHZN_ASYNC_NO_STATS
+            _stats_update([&](_stats_shard &s){
+                _stats_add<std::uint64_t>(s.notifies,1);
+                s.fanout.add(fanout);
+            });
+#endif
+        }
+
+        // a slot may leave on another thread than it joined, only the sum over shards is meaningful
+        inline void _stats_waiters([[maybe_unused]] std::ptrdiff_t count) noexcept{
+#ifndef CHZN_ASYNC_NO_STATS
+            _stats_update([&](_stats_shard &s){_stats_add<std::int64_t>(s.waiters,count);});
+#endif
+        }
+
+#ifdef CHZN_ASYNC_STATS_LATENCY
+        inline std::uint64_t _latency_now() noexcept{return _trace_clock::now();}
+
+        inline void _latency_record(const char *what,std::uint64_t ticks) noexcept{
+            _stats_update([&](_stats_shard &s){s.record_latency(what,ticks);});
+        }
+#endif
+    }
+
+    namespace stats{
+        inline report snapshot(){
+            auto &registry=_detail::_stats_registry::instance();
+#ifdef CHZN_ASYNC_STATS_LATENCY
+            _detail::_trace_time_converter to_ns(registry.start);
+#endif
+            report r;
+            std::lock_guard lock(registry.mutex);
+            auto read=[&](const _detail::_stats_shard &s){
+                r.live_frames+=s.live_frames.load(std::memory_order_relaxed);
+                r.live_frame_bytes+=s.live_frame_bytes.load(std::memory_order_relaxed);
+                r.frames+=s.frames.load(std::memory_order_relaxed);
+                r.adopted+=s.adopted.load(std::memory_order_relaxed);
+                r.notifies+=s.notifies.load(std::memory_order_relaxed);
+                r.waiters+=s.waiters.load(std::memory_order_relaxed);
+                s.fanout.read(r.notify_fanout);
+#ifdef CHZN_ASYNC_STATS_LATENCY
+                for(auto &slot:s.latency){
+                    auto what=slot.what.load(std::memory_order_acquire);
+                    if(!what)continue;
+                    std::string name(_detail::_trace_type_name(what));
+                    auto it=std::find_if(r.latency.begin(),r.latency.end(),[&](auto &l){return l.awaitable==name;});
+                    if(it==r.latency.end())it=r.latency.insert(it,{std::move(name),{}});
+                    histogram ticks;
+                    slot.ticks.load(std::memory_order_relaxed)->read(ticks);
+                    for(std::size_t b=0;b<histogram::buckets;++b)
+                        if(ticks.counts[b]){
+                            auto mid=histogram::lowest(b)/2+histogram::highest(b)/2;
+                            it->ns.add(static_cast<std::uint64_t>(static_cast<double>(mid)*to_ns.ns_per_tick),ticks.counts[b]);
+                        }
+                }
+#endif
+            };
+            for(auto &s:registry.shards)read(*s);
+            read(registry.orphan);
+            return r;
+        }
+    }
+}
+
+
+/*
+ * version 1.20.0 Watchdog
+ * 2026/10/16
+ * type:
+ * - chzn::slow_resume
+ *   - frame: address of the coroutine frame;
+ *   - location: where the coroutine is defined, line 0 if it is not an async or task;
+ *   - resumed_by: the awaited type whose co_await resumed it, "initial_suspend" for the first run;
+ *   - suspended_on: the awaited type it suspends on next, "final_suspend",
+ *     or empty if it suspended on another awaitable and returned to its resumer;
+ *   - elapsed: time from resume to suspend;
+ * - chzn::watchdog_sink
+ *   void(*)(const chzn::slow_resume &), called in the thread of the slow coroutine when it suspends;
+ * function:
+ * - chzn::set_watchdog(duration budget,watchdog_sink sink=nullptr)
+ *   report each resume slice longer than budget to sink, to stderr if sink is nullptr;
+ *   spins about 1ms to calibrate the time stamp counter;
+ * - chzn::stop_watchdog()
+ * changes:
+ * - define CHZN_ASYNC_WATCHDOG before include to time resume slices: from the resume of a co_await of async
+ *   or notifier in any coroutine, or of any co_await in task, or the first run of async and task,
+ *   to the next such suspend or final suspend,
+ *   or until it returns to the notifier, executor, event loop or co_returner resuming it;
+ *   a coroutine resumed inside another one pauses its slice, a task started inside another one ends it;
+ *   two reads of time stamp counter per slice when set, a thread local slice, no lock; without it nothing is timed;
+ * - get_return_object of async and task captures std::source_location by a default argument;
+ * - await_suspend of async, notifier and task awaiters are templates on the promise of the awaiting coroutine,
+ *   chzn::awaiter accepts such awaiters;
+ * */
+#include <chrono>
+namespace chzn{
+    struct slow_resume{
+        const void *frame;
+        std::source_location location;
+        std::string_view resumed_by;
+        std::string_view suspended_on;
+        std::chrono::nanoseconds elapsed;
+    };
+
+    using watchdog_sink=void(*)(const slow_resume &);
+
+    namespace _detail{
+        struct _watchdog_config{
+            static constexpr std::uint64_t off=~std::uint64_t(0);
+
+            std::atomic<std::uint64_t> budget=off; // in ticks
+            std::atomic<watchdog_sink> sink=nullptr;
+            std::atomic<double> ns_per_tick=1;
+
+            static _watchdog_config &instance() noexcept{
+                static _watchdog_config c;
+                return c;
+            }
+        };
+
+        inline void _watchdog_print(const slow_resume &r){
+            std::fprintf(stderr,"chzn watchdog: coroutine %p (%s:%u %s) ran %.3f ms, resumed by %.*s, suspended on %.*s\n",
+                         r.frame,r.location.file_name(),static_cast<unsigned>(r.location.line()),r.location.function_name(),
+                         static_cast<double>(r.elapsed.count())/1e6,
+                         static_cast<int>(r.resumed_by.size()),r.resumed_by.data(),
+                         static_cast<int>(r.suspended_on.size()),r.suspended_on.data());
+        }
+
+#ifdef CHZN_ASYNC_WATCHDOG
+        inline _watchdog_slice &_watchdog_current() noexcept{
+            thread_local _watchdog_slice s;
+            return s;
+        }
+
+        [[gnu::noinline,gnu::cold]] inline void _watchdog_report(const _watchdog_slice &slice,const char *what,
+                                                               std::uint64_t ticks) noexcept{
+            auto &c=_watchdog_config::instance();
+            slow_resume r{slice.frame,slice.where?slice.where->location:std::source_location{},
+                          slice.what?_trace_type_name(slice.what):"",what?_trace_type_name(what):"",
+                          std::chrono::nanoseconds(static_cast<std::int64_t>(
+                                  static_cast<double>(ticks)*c.ns_per_tick.load(std::memory_order_relaxed)))};
+            auto sink=c.sink.load(std::memory_order_acquire);
+#if __cpp_exceptions
+            try{
+                sink?sink(r):_watchdog_print(r);
+            }catch(...){} // a sink must not break the coroutine being suspended
+#else
+            sink?sink(r):_watchdog_print(r);
+#endif
+        }
+
+        inline void _watchdog_resume(const void *frame,const _where *where,const char *what) noexcept{
+            if(_watchdog_config::instance().budget.load(std::memory_order_relaxed)==_watchdog_config::off)return;
+            _watchdog_current()={_trace_clock::now(),frame,where,what};
+        }
+
+        // any suspend ends the slice, only the coroutine of the slice is checked
+        inline void _watchdog_suspend(const void *frame,const char *what) noexcept{
+            auto &s=_watchdog_current();
+            if(!s.frame)[[likely]]return;
+            auto slice=s;
+            s.frame=nullptr;
+            if(slice.frame!=frame)return;
+            auto ticks=_trace_clock::now()-slice.start;
+            if(ticks>_watchdog_config::instance().budget.load(std::memory_order_relaxed))[[unlikely]]
+                _watchdog_report(slice,what,ticks);
+        }
+
+        inline _watchdog_nest::_watchdog_nest() noexcept:outer(_watchdog_current()){
+            if(!outer.frame)return;
+            outer.start=_trace_clock::now()-outer.start;
+            _watchdog_current().frame=nullptr;
+        }
+
+        inline _watchdog_nest::~_watchdog_nest(){
+            auto &s=_watchdog_current();
+            if(s.frame)_watchdog_suspend(s.frame,nullptr); // returned to here, suspended on something else
+            if(!outer.frame)return;
+            s=outer;
+            s.start=_trace_clock::now()-outer.start;
+        }
+#endif
+    }
+
+    template<typename Rep,typename Period>
+    void set_watchdog(std::chrono::duration<Rep,Period> budget,watchdog_sink sink=nullptr){
+        auto &c=_detail::_watchdog_config::instance();
+        _detail::_trace_time_converter to_ns(_detail::_trace_clock::sample());
+        c.ns_per_tick.store(to_ns.ns_per_tick,std::memory_order_relaxed);
+        c.sink.store(sink,std::memory_order_release);
+        auto ns=std::chrono::duration<double,std::nano>(budget).count();
+        c.budget.store(ns>0?static_cast<std::uint64_t>(ns/to_ns.ns_per_tick):0,std::memory_order_relaxed);
+    }
+
+    inline void stop_watchdog() noexcept{
+        _detail::_watchdog_config::instance().budget.store(_detail::_watchdog_config::off,std::memory_order_relaxed);
+    }
+}
+
+
+/*
+ * version 1.21.0 Coop
+ * 2026/10/16
+ * function:
+ * - chzn::yield()
+ *   co_await it to let other coroutines run: the coroutine is posted to current executor,
+ *   or queued behind notified waiters if a notify is resuming them in a flat loop (resume_policy fifo/lifo),
+ *   or continues at once if there is neither;
+ *   in task, it is canceled as a foreign awaiter;
+ * - chzn::set_coop_budget(std::size_t resumptions,duration time=0)
+ *   for all threads, 0 is unlimited, both 0 turn it off (default);
+ *   time spins about 1ms to calibrate the time stamp counter;
+ * changes:
+ * - when an async completes at once and its caller, an async, would continue inline in the same stack,
+ *   it is counted as a resumption; after the budget of resumptions or time is used up in a thread,
+ *   the caller is posted to current executor instead, as if it co_await chzn::yield() first;
+ *   the budget is refilled then, by chzn::yield(), and whenever a notifier, co_returner, executor, thread_pool,
+ *   io_context or timer resumes a coroutine, time is measured from that resume;
+ *   without current executor, the caller continues inline;
+ * - callers in task are never rescheduled by the budget, a posted task could be canceled and destroyed;
+ * */
+namespace chzn{
+    namespace _detail{
+        struct _coop_config{
+            std::atomic<std::size_t> resumptions=0;
+            std::atomic<std::uint64_t> ticks=0;
+
+            static _coop_config &instance() noexcept{
+                static _coop_config c;
+                return c;
+            }
+        };
+
+        // used budget of this thread
+        struct _coop_state{
+            std::size_t used=0;
+            std::uint64_t start=0;
+
+            static _coop_state &local() noexcept{
+                thread_local _coop_state s;
+                return s;
+            }
+
+            void refill() noexcept{
+                used=0;
+                start=_coop_config::instance().ticks.load(std::memory_order_relaxed)?_trace_clock::now():0;
+            }
+        };
+
+        // a scheduler or notifier resumes a coroutine, a new slice
+        inline void _coop_refill() noexcept{
+            auto &c=_coop_config::instance();
+            if(!c.resumptions.load(std::memory_order_relaxed)&&!c.ticks.load(std::memory_order_relaxed))[[likely]]return;
+            _coop_state::local().refill();
+        }
+
+        inline bool _coop_exhausted() noexcept{
+            auto &c=_coop_config::instance();
+            auto n=c.resumptions.load(std::memory_order_relaxed);
+            auto t=c.ticks.load(std::memory_order_relaxed);
+            if(!n&&!t)[[likely]]return false;
+            auto &s=_coop_state::local();
+            if(n&&++s.used>=n){
+                s.refill();
+                return true;
+            }
+            if(t){
+                auto now=_trace_clock::now();
+                if(!s.start)s.start=now; // not resumed by a scheduler since the budget was set
+                else if(now-s.start>=t){
+                    s.refill();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        inline std::coroutine_handle<> _coop_reschedule(std::coroutine_handle<> handle){
+            auto e=current_executor();
+            if(!e)return handle;
+            e.post(handle);
+            return std::noop_coroutine();
+        }
+
+        struct _yield_awaiter:public _notifier_slot_base{
+            // posted handle can not be taken back, task wraps it in a frame to cancel
+            void await_cancel() = delete;
+
+            static constexpr bool await_ready() noexcept{return false;}
+
+            bool await_suspend(std::coroutine_handle<> handle){
+                _coop_state::local().refill();
+                if(auto e=current_executor()){
+                    e.post(handle);
+                    return true;
+                }
+                auto &q=_run_queue::local();
+                if(!q.draining)return false;
+                coroutine=handle;
+                // run after slots queued now, lifo drains from the back
+                auto &before=q.policy==resume_policy::lifo?*q.the_end.next:q.the_end;
+                last=before.last;
+                next=&before;
+                before.last->next=this;
+                before.last=this;
+                return true;
+            }
+
+            static void await_resume() noexcept{}
+        };
+    }
+
+    inline _detail::_yield_awaiter yield() noexcept{return {};}
+
+    inline void set_coop_budget(std::size_t resumptions) noexcept{
+        auto &c=_detail::_coop_config::instance();
+        c.ticks.store(0,std::memory_order_relaxed);
+        c.resumptions.store(resumptions,std::memory_order_relaxed);
+    }
+
+    template<typename Rep,typename Period>
+    void set_coop_budget(std::size_t resumptions,std::chrono::duration<Rep,Period> time){
+        auto &c=_detail::_coop_config::instance();
+        std::uint64_t ticks=0;
+        if(time>time.zero()){
+            _detail::_trace_time_converter to_ns(_detail::_trace_clock::sample());
+            ticks=std::max<std::uint64_t>(static_cast<std::uint64_t>(
+                    std::chrono::duration<double,std::nano>(time).count()/to_ns.ns_per_tick),1);
+        }
+        c.ticks.store(ticks,std::memory_order_relaxed);
+        c.resumptions.store(resumptions,std::memory_order_relaxed);
+    }
+}
+
+#endif
@@ -0,0 +1,530 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <optional>
+#include <atomic>
+#include <thread>
+#include "async.hpp"
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BENCH_PERF 1
+#endif
+using namespace std;
+using namespace chzn;
+
+// bench [--json] [--filter text] [--baseline path]
+// a text table by default, --json print results as json to stdout,
+// instructions/op is user space instructions by perf_event_open, missing or null if not permitted;
+// built with CHZN_ASYNC_TRACE, "trace event" is the cost of one event on the hooked path, against
+// "async co_await async" of the bench at path built without it (BENCH_BASELINE by default)
+
+// count global allocations, frames from frame pool are counted by frame_pool_statistics()
+static atomic<size_t> allocations=0;
+
+void *operator new(size_t size){
+    allocations.fetch_add(1,memory_order_relaxed);
+    if(auto p=malloc(size?size:1))return p;
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept{free(p);}
+
+void operator delete(void *p,size_t) noexcept{free(p);}
+
+// instructions retired by this thread
+struct instruction_counter{
+    int fd=-1;
+
+    instruction_counter(){
+#ifdef BENCH_PERF
+        perf_event_attr attr{};
+        attr.size=sizeof(attr);
+        attr.type=PERF_TYPE_HARDWARE;
+        attr.config=PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled=1;
+        attr.exclude_kernel=1;
+        attr.exclude_hv=1;
+        fd=static_cast<int>(syscall(SYS_perf_event_open,&attr,0,-1,-1,0));
+#endif
+    }
+
+    instruction_counter(instruction_counter &) = delete;
+
+    ~instruction_counter(){
+#ifdef BENCH_PERF
+        if(fd>=0)close(fd);
+#endif
+    }
+
+    void start() const{
+#ifdef BENCH_PERF
+        if(fd<0)return;
+        ioctl(fd,PERF_EVENT_IOC_RESET,0);
+        ioctl(fd,PERF_EVENT_IOC_ENABLE,0);
+#endif
+    }
+
+    optional<uint64_t> stop() const{
+#ifdef BENCH_PERF
+        if(fd<0)return nullopt;
+        ioctl(fd,PERF_EVENT_IOC_DISABLE,0);
+        uint64_t count;
+        if(read(fd,&count,sizeof(count))==sizeof(count))return count;
+#endif
+        return nullopt;
+    }
+};
+
+struct result{
+    string name;
+    size_t ops;
+    double ns,allocs,frames;
+    optional<double> instructions;
+};
+
+static vector<result> results;
+static vector<string> failures; // checks done by cases, exit code 1 if any
+static const char *filter=nullptr;
+static bool json=false;
+#ifdef BENCH_BASELINE
+static const char *baseline=BENCH_BASELINE;
+#else
+static const char *baseline=nullptr;
+#endif
+
+void report(result r){
+    if(!json){
+        printf("%-32s %9.2f ns/op %6.2f allocs/op %6.2f frames/op",r.name.c_str(),r.ns,r.allocs,r.frames);
+        if(r.instructions)printf(" %9.1f instructions/op",*r.instructions);
+        printf("\n");
+    }
+    results.push_back(std::move(r));
+}
+
+// time run(prepare(ops)), prepare is not measured
+template<typename P,typename F>
+void measure(const string &name,size_t ops,P &&prepare,F &&run){
+    if(filter&&name.find(filter)==string::npos)return;
+    static instruction_counter counter;
+    auto state=prepare(ops);
+    auto a=allocations.load();
+    auto s=frame_pool_statistics();
+    counter.start();
+    auto begin=chrono::steady_clock::now();
+    run(state);
+    auto ns=chrono::duration<double,nano>(chrono::steady_clock::now()-begin).count();
+    auto instructions=counter.stop();
+    auto e=frame_pool_statistics();
+    result r{name,ops,ns/ops,double(allocations.load()-a)/ops,double(e.hits+e.misses-s.hits-s.misses)/ops,nullopt};
+    if(instructions)r.instructions=double(*instructions)/ops;
+    report(std::move(r));
+}
+
+template<typename F>
+void measure(const string &name,size_t ops,F &&run){
+    measure(name,ops,[](size_t n){return n;},std::forward<F>(run));
+}
+
+void print_json(){
+    printf("{\n  \"benchmarks\": [\n");
+    for(size_t i=0;i<results.size();++i){
+        auto &r=results[i];
+        printf("    {\"name\": \"%s\", \"ops\": %zu, \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f, "
+               "\"frames_per_op\": %.3f, \"instructions_per_op\": ",r.name.c_str(),r.ops,r.ns,r.allocs,r.frames);
+        if(r.instructions)printf("%.1f",*r.instructions);
+        else printf("null");
+        printf("}%s\n",i+1<results.size()?",":"");
+    }
+    printf("  ],\n  \"failures\": [");
+    for(size_t i=0;i<failures.size();++i)printf("%s\"%s\"",i?", ":"",failures[i].c_str());
+    printf("]\n}\n");
+}
+
+void check(const string &what,bool ok){
+    if(ok)return;
+    if(!json)printf("FAIL %s\n",what.c_str());
+    failures.push_back(what);
+}
+
+async<size_t> leaf(size_t i){co_return i;}
+
+volatile size_t sink;
+
+void await_leaves(size_t n){
+    [](size_t n)->async<void>{
+        size_t s=0;
+        for(size_t i=0;i<n;++i)s+=co_await leaf(i);
+        sink=s;
+    }(n);
+}
+
+#ifdef CHZN_ASYNC_TRACE
+// ns/op of a case run by the bench at baseline
+optional<double> baseline_ns(const string &name){
+    if(!baseline)return nullopt;
+    string command="\""s+baseline+"\" --json --filter \""+name+"\"";
+    auto pipe=popen(command.c_str(),"r");
+    if(!pipe)return nullopt;
+    string out;
+    char buffer[4096];
+    for(size_t n;(n=fread(buffer,1,sizeof(buffer),pipe));)out.append(buffer,n);
+    pclose(pipe);
+    auto at=out.find("\"ns_per_op\": ");
+    if(at==string::npos)return nullopt;
+    return strtod(out.c_str()+at+13,nullptr);
+}
+#endif
+
+async<size_t> chain(size_t depth){
+    if(!depth)co_return 0;
+    co_return co_await chain(depth-1)+1;
+}
+
+struct ready_value{
+    size_t value;
+
+    bool await_ready() const noexcept{return true;}
+
+    void await_suspend(coroutine_handle<>) const noexcept{}
+
+    size_t await_resume() const noexcept{return value;}
+};
+
+// too big for inline buffer of chzn::awaiter
+struct big_ready_value:public ready_value{
+    char padding[CHZN_AWAITER_BUFFER_SIZE];
+};
+
+async_generator<size_t> count_up(size_t n){
+    for(size_t i=0;i<n;++i)co_yield i;
+}
+
+int main(int argc,char **argv){
+    for(int i=1;i<argc;++i){
+        if(!strcmp(argv[i],"--json"))json=true;
+        else if(!strcmp(argv[i],"--filter")&&i+1<argc)filter=argv[++i];
+        else if(!strcmp(argv[i],"--baseline")&&i+1<argc)baseline=argv[++i];
+    }
+    constexpr size_t ops=1000000;
+
+    measure("async co_await async",ops,await_leaves);
+    // per chain, depth frames each
+    for(size_t depth:{1,8,64,512})
+        measure("async chain depth "+to_string(depth),ops/depth,[depth](size_t n){
+            [](size_t n,size_t depth)->async<void>{
+                size_t s=0;
+                for(size_t i=0;i<n;++i)s+=co_await chain(depth);
+                sink=s;
+            }(n,depth);
+        });
+    measure("when_all 2 async",ops,[](size_t n){
+        [](size_t n)->async<void>{
+            size_t s=0;
+            for(size_t i=0;i<n;++i){
+                auto [a,b]=co_await when_all(leaf(i),leaf(i));
+                s+=a+b;
+            }
+            sink=s;
+        }(n);
+    });
+    measure("task co_await async",ops,[](size_t n){
+        [](size_t n)->task{
+            size_t s=0;
+            for(size_t i=0;i<n;++i)s+=co_await leaf(i);
+            sink=s;
+        }(n);
+    });
+    measure("task co_await foreign awaiter",ops,[](size_t n){
+        [](size_t n)->task{
+            for(size_t i=0;i<n;++i)co_await suspend_never{};
+        }(n);
+    });
+    measure("task co_await notifier",ops,[](size_t n){
+        notifier<size_t> value;
+        auto t=[](notifier<size_t> &value,size_t n)->task{
+            size_t s=0;
+            for(size_t i=0;i<n;++i)s+=co_await value;
+            sink=s;
+        }(value,n);
+        for(size_t i=0;i<n;++i)value.notify(i);
+    });
+
+    // per waiter resumed, waiters are parked before timing
+    struct fan_out{
+        vector<notifier<size_t>> notifiers;
+        vector<task> waiters;
+    };
+    for(size_t width:{1,10,100,1000,10000,100000})
+        measure("notify fan-out "+to_string(width),ops/10,[width](size_t n){
+            auto f=make_unique<fan_out>();
+            f->notifiers=vector<notifier<size_t>>(max<size_t>(n/width,1));
+            f->waiters.reserve(f->notifiers.size()*width);
+            for(auto &value:f->notifiers)
+                for(size_t i=0;i<width;++i)
+                    f->waiters.push_back([](notifier<size_t> &value)->task{sink=co_await value;}(value));
+            return f;
+        },[](unique_ptr<fan_out> &f){
+            for(size_t i=0;i<f->notifiers.size();++i)f->notifiers[i].notify(i);
+        });
+
+    // create a task, cancel it by destroying it
+    measure("task cancel notifier",ops,[](size_t n){
+        notifier<size_t> value;
+        for(size_t i=0;i<n;++i)
+            [](notifier<size_t> &value)->task{sink=co_await value;}(value);
+    });
+    measure("task cancel async",ops/10,[](size_t n){
+        notifier<size_t> value;
+        for(size_t i=0;i<n;++i)
+            [](notifier<size_t> &value)->task{
+                sink=co_await [](notifier<size_t> &value)->async<size_t>{co_return co_await value;}(value);
+            }(value);
+        value.notify(0); // detached asyncs complete and free themselves
+    });
+
+    // completed from outside, one resume per op
+    measure("do_async",ops,[](size_t n){
+        co_returner<size_t> *pending=nullptr;
+        auto t=[](co_returner<size_t> *&pending,size_t n)->task{
+            size_t s=0;
+            for(size_t i=0;i<n;++i)s+=co_await do_async<size_t>([&](co_returner<size_t> &r){pending=&r;});
+            sink=s;
+        }(pending,n);
+        for(size_t i=0;i<n;++i)pending->return_value(i);
+    });
+    measure("awaiter<T> inline",ops,[](size_t n){
+        [](size_t n)->async<void>{
+            size_t s=0;
+            for(size_t i=0;i<n;++i)s+=co_await awaiter<size_t>(ready_value{i});
+            sink=s;
+        }(n);
+    });
+    measure("awaiter<T> heap",ops,[](size_t n){
+        [](size_t n)->async<void>{
+            size_t s=0;
+            for(size_t i=0;i<n;++i)s+=co_await awaiter<size_t>(big_ready_value{{i},{}});
+            sink=s;
+        }(n);
+    });
+
+    // uncontended
+    measure("channel send recv",ops,[](size_t n){
+        channel<size_t> ch(64);
+        [](channel<size_t> &ch,size_t n)->async<void>{
+            size_t s=0;
+            for(size_t i=0;i<n;++i){
+                co_await ch.send(i);
+                s+=*co_await ch.recv();
+            }
+            sink=s;
+        }(ch,n);
+    });
+    // per value, batches of 16 through a channel of 64
+    measure("channel send_many recv_many",ops,[](size_t n){
+        channel<size_t> ch(64);
+        [](channel<size_t> &ch,size_t n)->async<void>{
+            size_t in[16],out[16],s=0;
+            for(size_t i=0;i<n;i+=16){
+                for(size_t j=0;j<16;++j)in[j]=i+j;
+                co_await ch.send_many(in);
+                for(size_t got=0;got<16;)got+=co_await ch.recv_many(span(out+got,16-got));
+                for(auto v:out)s+=v;
+            }
+            sink=s;
+        }(ch,n);
+    });
+    measure("async_mutex scoped_lock",ops,[](size_t n){
+        async_mutex m;
+        [](async_mutex &m,size_t n)->async<void>{
+            for(size_t i=0;i<n;++i){
+                auto guard=co_await m.scoped_lock();
+                sink=i;
+            }
+        }(m,n);
+    });
+    measure("shared_async ready",ops,[](size_t n){
+        auto shared=share(leaf(1));
+        [](shared_async<size_t> &shared,size_t n)->async<void>{
+            size_t s=0;
+            for(size_t i=0;i<n;++i)s+=co_await shared;
+            sink=s;
+        }(shared,n);
+    });
+    measure("async_cache hit",ops,[](size_t n){
+        async_cache<size_t,size_t> cache(16,eviction_policy::lru,{},1);
+        [](async_cache<size_t,size_t> &cache,size_t n)->async<void>{
+            size_t s=0;
+            for(size_t i=0;i<n;++i)s+=co_await cache.get(i%16,[](size_t k){return leaf(k);});
+            sink=s;
+        }(cache,n);
+    });
+    measure("task_group spawn",ops,[](size_t n){
+        task_group group;
+        [](task_group &group,size_t n)->async<void>{
+            for(size_t i=0;i<n;++i)group.spawn(leaf(i));
+            co_await group.join();
+        }(group,n);
+    });
+
+    // single thread, resumed inline
+    measure("task co_await concurrent_notifier",ops,[](size_t n){
+        concurrent_notifier<size_t> value;
+        auto t=[](concurrent_notifier<size_t> &value,size_t n)->task{
+            size_t s=0;
+            for(size_t i=0;i<n;++i)s+=co_await value;
+            sink=s;
+        }(value,n);
+        for(size_t i=0;i<n;++i)value.notify(i);
+    });
+    measure("task cancel concurrent_notifier",ops,[](size_t n){
+        concurrent_notifier<size_t> value;
+        for(size_t i=0;i<n;++i)
+            [](concurrent_notifier<size_t> &value)->task{sink=co_await value;}(value);
+    }); // nodes left by canceled waiters are freed by the destructor, in time
+    measure("async_generator next",ops,[](size_t n){
+        [](size_t n)->async<void>{
+            auto g=count_up(n);
+            size_t s=0;
+            while(auto v=co_await g.next())s+=*v;
+            sink=s;
+        }(n);
+    });
+
+    // uncontended, except the barrier which two coroutines pass in turn
+    measure("async_semaphore acquire release",ops,[](size_t n){
+        async_semaphore semaphore(1);
+        [](async_semaphore &semaphore,size_t n)->async<void>{
+            for(size_t i=0;i<n;++i){
+                co_await semaphore.acquire();
+                semaphore.release();
+            }
+        }(semaphore,n);
+    });
+    measure("async_shared_mutex scoped_lock_shared",ops,[](size_t n){
+        async_shared_mutex m;
+        [](async_shared_mutex &m,size_t n)->async<void>{
+            for(size_t i=0;i<n;++i){
+                auto guard=co_await m.scoped_lock_shared();
+                sink=i;
+            }
+        }(m,n);
+    });
+    measure("async_latch arrive_and_wait",ops,[](size_t n){
+        [](size_t n)->async<void>{
+            for(size_t i=0;i<n;++i){
+                async_latch latch(1);
+                co_await latch.arrive_and_wait();
+            }
+        }(n);
+    });
+    // per phase
+    measure("async_barrier 2 arrive_and_wait",ops,[](size_t n){
+        async_barrier barrier(2);
+        for(int k=0;k<2;++k)
+            [](async_barrier &barrier,size_t n)->async<void>{
+                for(size_t i=0;i<n;++i)co_await barrier.arrive_and_wait();
+            }(barrier,n);
+    });
+
+    // timers inserted by co_await and fired by one advance
+    measure("timer_wheel sleep_for fire",ops/10,[](size_t n){
+        timer_wheel wheel;
+        for(size_t i=0;i<n;++i)
+            []()->async<void>{co_await sleep_for(chrono::milliseconds(1));}();
+        wheel.advance(timer_wheel::clock::now()+chrono::seconds(1));
+    });
+    // the timer is inserted and canceled, the notifier wins
+    measure("with_timeout notifier",ops/10,[](size_t n){
+        timer_wheel wheel;
+        notifier<size_t> value;
+        auto t=[](notifier<size_t> &value,size_t n)->task{
+            size_t s=0;
+            for(size_t i=0;i<n;++i)s+=*co_await with_timeout(value,chrono::seconds(1));
+            sink=s;
+        }(value,n);
+        for(size_t i=0;i<n;++i)value.notify(i);
+    });
+
+    // hops of one coroutine, the runtime is set up before timing
+    struct pool_state{
+        atomic<bool> done=false;
+        thread_pool pool{1};
+    };
+    measure("thread_pool schedule",ops/10,[](size_t){return make_unique<pool_state>();},[](unique_ptr<pool_state> &p){
+        [](pool_state &p,size_t n)->async<void>{
+            co_await resume_on(p.pool.get_executor());
+            for(size_t i=0;i<n;++i)co_await p.pool.schedule();
+            p.done=true;
+            p.done.notify_one();
+        }(*p,ops/10);
+        p->done.wait(false);
+    });
+    // to shard 1 and back to shard 0 per op
+    struct shard_state{
+        atomic<bool> done=false;
+        shard_runtime runtime{2,1024,false};
+    };
+    measure("shard_runtime on_shard",ops/10,[](size_t){return make_unique<shard_state>();},[](unique_ptr<shard_state> &r){
+        [](shard_state &r,size_t n)->async<void>{
+            co_await resume_on(r.runtime.get_executor(0));
+            size_t s=0;
+            for(size_t i=0;i<n;++i)s+=co_await on_shard(1,[i]{return i;});
+            sink=s;
+            r.done=true;
+            r.done.notify_one();
+        }(*r,ops/10);
+        r->done.wait(false);
+    });
+#if defined(__linux__)
+    // posted to the loop and resumed in its next iteration
+    measure("io_context yield",ops,[](size_t n){
+        io_context io;
+        [](io_context &io,size_t n)->async<void>{
+            co_await resume_on(io.get_executor());
+            for(size_t i=0;i<n;++i)co_await yield();
+        }(io,n);
+        io.run();
+    });
+    // async co_await async in a loop, reposted after every 64 resumptions
+    measure("coop budget 64",ops,[](size_t n){
+        io_context io;
+        set_coop_budget(64);
+        [](io_context &io,size_t n)->async<void>{
+            co_await resume_on(io.get_executor());
+            size_t s=0;
+            for(size_t i=0;i<n;++i)s+=co_await leaf(i);
+            sink=s;
+        }(io,n);
+        io.run();
+        set_coop_budget(0);
+    });
+#endif
+
+#ifdef CHZN_ASYNC_TRACE
+    // traced minus untraced async co_await async per event, should stay under 30 ns
+    if(auto traced=find_if(results.begin(),results.end(),[](const result &r){return r.name=="async co_await async";});
+       traced!=results.end()){
+        auto untraced=baseline_ns(traced->name);
+        if(!untraced)check("trace event: no baseline, give --baseline a bench built without CHZN_ASYNC_TRACE",false);
+        else{
+            constexpr size_t sample=1000; // within a trace ring
+            clear_trace();
+            await_leaves(sample);
+            auto events=double(trace_events().size())/sample;
+            report({"trace event",ops,(traced->ns-*untraced)/events,0,0,nullopt});
+            check("trace event under 30 ns",results.back().ns<30);
+        }
+    }
+#endif
+
+    if(json)print_json();
+    return failures.empty()?0:1;
+}
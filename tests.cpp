@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+#include "async.hpp"
+using namespace std;
+using namespace chzn;
+
+// tests, correctness checks of races and corner cases, run by ctest
+// print each failed check, exit 1 if any
+
+static size_t failures=0;
+
+void check(const string &what,bool ok){
+    if(ok)return;
+    printf("FAIL %s\n",what.c_str());
+    ++failures;
+}
+
+// values sent before close are all received, the sender races with a receiver in a pool checking closed
+void channel_close_drain(){
+    constexpr size_t rounds=25000,per_round=4;
+    thread_pool pool(1);
+    atomic<size_t> received=0,rounds_done=0;
+    for(size_t round=0;round<rounds;++round){
+        channel<size_t> ch(per_round);
+        [](thread_pool &pool,channel<size_t> &ch,atomic<size_t> &received,atomic<size_t> &done)->async<void>{
+            co_await pool.schedule();
+            while(co_await ch.recv())received.fetch_add(1,memory_order_relaxed);
+            done.fetch_add(1,memory_order_release);
+        }(pool,ch,received,rounds_done);
+        for(size_t i=0;i<per_round;++i)ch.try_send(i);
+        ch.close();
+        while(rounds_done.load(memory_order_acquire)<=round)this_thread::yield();
+    }
+    check("channel close drain",received==rounds*per_round);
+}
+
+// a batch bigger than capacity is sent in order while a receiver takes batches
+void channel_send_many(){
+    channel<size_t> ch(8);
+    check("try_send_many fills free slots",[&]{
+        vector<size_t> in(12,1);
+        return ch.try_send_many(in)==8&&!ch.try_send_many(in);
+    }());
+    while(ch.try_recv());
+
+    vector<size_t> in(1000),out;
+    iota(in.begin(),in.end(),size_t(0));
+    auto sent_values=in;
+    size_t sent=0;
+    [](channel<size_t> &ch,vector<size_t> &in,size_t &sent)->async<void>{
+        sent=co_await ch.send_many(in); // values are moved out
+        ch.close();
+    }(ch,in,sent);
+    [](channel<size_t> &ch,vector<size_t> &out)->async<void>{
+        size_t buffer[5];
+        while(auto n=co_await ch.recv_many(buffer))out.insert(out.end(),buffer,buffer+n);
+    }(ch,out);
+    check("send_many sends all",sent==in.size());
+    check("send_many keeps order",out==sent_values);
+
+    vector<size_t> late(3,7);
+    size_t after_close=1;
+    [](channel<size_t> &ch,vector<size_t> &late,size_t &after_close)->async<void>{
+        after_close=co_await ch.send_many(late);
+    }(ch,late,after_close);
+    check("send_many after close sends none",after_close==0);
+}
+
+// many senders of batches and many receivers in a pool, every value arrives once
+void channel_send_many_threads(){
+    constexpr size_t senders=4,receivers=4,batches=2000,batch=7;
+    vector<atomic<size_t>> seen(senders*batches*batch);
+    {
+        channel<size_t> ch(16);
+        thread_pool pool(4);
+        atomic<size_t> senders_done=0,receivers_done=0;
+        for(size_t s=0;s<senders;++s)
+            [](thread_pool &pool,channel<size_t> &ch,size_t s,atomic<size_t> &done)->async<void>{
+                co_await pool.schedule();
+                vector<size_t> in(batch);
+                for(size_t b=0;b<batches;++b){
+                    for(size_t i=0;i<batch;++i)in[i]=(s*batches+b)*batch+i;
+                    co_await ch.send_many(in);
+                }
+                if(done.fetch_add(1)+1==senders)ch.close();
+            }(pool,ch,s,senders_done);
+        for(size_t r=0;r<receivers;++r)
+            [](thread_pool &pool,channel<size_t> &ch,vector<atomic<size_t>> &seen,atomic<size_t> &done)->async<void>{
+                co_await pool.schedule();
+                size_t buffer[3];
+                while(auto n=co_await ch.recv_many(buffer))
+                    for(size_t i=0;i<n;++i)seen[buffer[i]].fetch_add(1,memory_order_relaxed);
+                done.fetch_add(1,memory_order_release);
+            }(pool,ch,seen,receivers_done);
+        while(receivers_done.load(memory_order_acquire)<receivers)this_thread::yield();
+    }
+    check("send_many across threads delivers each value once",all_of(seen.begin(),seen.end(),[](auto &n){return n==1;}));
+}
+
+// a canceled task waiting on a concurrent_notifier frees its frame at once, notify skips it
+void concurrent_notifier_cancel(){
+    concurrent_notifier<int> n;
+    int resumed=0;
+    auto waiter=[](concurrent_notifier<int> &n,int &resumed)->task{
+        resumed+=co_await n;
+    };
+    auto frames=stats::snapshot().live_frames;
+    task kept=waiter(n,resumed);
+    {
+        task canceled=waiter(n,resumed);
+        canceled.cancel();
+    }
+    check("canceled concurrent_notifier waiter frees its frame",!stats::enabled||stats::snapshot().live_frames==frames+1);
+    n.notify(5);
+    check("concurrent_notifier notify skips canceled waiters",resumed==5);
+}
+
+// half of the waiters are canceled, another thread notifies, every kept waiter is resumed once there
+void concurrent_notifier_cancel_threads(){
+    constexpr int rounds=2000,waiters=8;
+    atomic<int> resumed=0;
+    for(int round=0;round<rounds;++round){
+        concurrent_notifier<void> n;
+        vector<task> tasks;
+        for(int i=0;i<waiters;++i)
+            tasks.push_back([](concurrent_notifier<void> &n,atomic<int> &resumed)->task{
+                co_await n;
+                resumed.fetch_add(1,memory_order_relaxed);
+            }(n,resumed));
+        for(int i=0;i<waiters;i+=2)tasks[i]=task{};
+        thread notifier([&]{n.notify();});
+        notifier.join();
+    }
+    check("concurrent_notifier resumes each kept waiter once",resumed==rounds*waiters/2);
+}
+
+#if __cpp_exceptions
+// the first error detaches running children, join does not wait for them, they free themselves later
+void task_group_first_error(){
+    notifier<int> fail,release;
+    int finished=0;
+    bool joined=false,thrown=false;
+    {
+        task_group group;
+        for(int i=0;i<3;++i)
+            group.spawn([](notifier<int> &release,int &finished)->async<void>{
+                co_await release;
+                ++finished;
+            }(release,finished));
+        group.spawn([](notifier<int> &fail)->async<void>{
+            co_await fail;
+            throw runtime_error("fail");
+        }(fail));
+        [](task_group &group,bool &joined,bool &thrown)->async<void>{
+            try{
+                co_await group.join();
+            }catch(runtime_error &){
+                thrown=true;
+            }
+            joined=true;
+        }(group,joined,thrown);
+        fail.notify(0);
+        check("task_group join returns on the first error",joined&&thrown&&group.size()==0);
+    }
+    release.notify(0);
+    check("task_group detached children run to the end",finished==3);
+}
+
+// children fail and complete on a pool while siblings are detached,
+// the failing child is spawned last, spawns after the error would be dropped
+void task_group_first_error_threads(){
+    constexpr int rounds=200,children=16;
+    atomic<int> done=0;
+    for(int round=0;round<rounds;++round){
+        thread_pool pool(4);
+        atomic<bool> joined=false;
+        task_group group;
+        for(int i=0;i<children;++i)
+            group.spawn([](thread_pool &pool,atomic<int> &done,int i)->async<void>{
+                co_await pool.schedule();
+                if(i==children-1)throw runtime_error("fail");
+                done.fetch_add(1);
+            }(pool,done,i));
+        [](task_group &group,atomic<bool> &joined)->async<void>{
+            try{
+                co_await group.join();
+            }catch(runtime_error &){}
+            joined=true;
+        }(group,joined);
+        while(!joined)this_thread::yield();
+    } // the pool finishes detached children before it goes
+    check("task_group children detached across threads complete",done==rounds*(children-1));
+}
+#endif
+
+#if __cpp_lib_expected
+// counts live instances, to check locals and error values are destroyed once
+struct counted{
+    static inline int live=0;
+
+    counted() noexcept{++live;}
+
+    counted(const counted &) noexcept{++live;}
+
+    ~counted(){--live;}
+};
+
+async<expected<int,counted>> expected_leaf(bool ok){
+    if(!ok)co_return unexpected(counted{});
+    co_return 1;
+}
+
+// co_await of an error finishes at once, nothing after it runs, locals are destroyed
+void expected_short_circuit(){
+    int after=0;
+    auto parent=[](bool ok,int &after)->async<expected<int,counted>>{
+        counted local;
+        auto a=co_await expected_leaf(ok);
+        ++after;
+        expected<int,counted> e=2;
+        auto b=co_await e;
+        ++after;
+        co_return a+b;
+    };
+    optional<expected<int,counted>> ok,failed;
+    [&]()->async<void>{
+        ok=co_await parent(true,after);
+        failed=co_await parent(false,after);
+    }();
+    check("expected value passes through",ok&&ok->has_value()&&**ok==3);
+    check("expected error short circuits",failed&&!failed->has_value()&&after==2);
+    check("expected error and locals live once",counted::live==1);
+    failed.reset();
+    check("expected teardown leaves nothing",counted::live==0);
+
+    optional<expected<int,no_longer_awaitable>> gone;
+    {
+        notifier<int> dying;
+        [](notifier<int> &dying,optional<expected<int,no_longer_awaitable>> &gone)->async<void>{
+            gone=co_await dying.checked();
+        }(dying,gone);
+    }
+    check("checked notifier reports destruction",gone&&!gone->has_value());
+}
+#endif
+
+int main(){
+    channel_close_drain();
+    channel_send_many();
+    channel_send_many_threads();
+    concurrent_notifier_cancel();
+    concurrent_notifier_cancel_threads();
+#if __cpp_exceptions
+    task_group_first_error();
+    task_group_first_error_threads();
+#endif
+#if __cpp_lib_expected
+    expected_short_circuit();
+#endif
+    return failures?1:0;
+}